@@ -1,10 +1,15 @@
 #version 330 core
 
 in vec2 tex;
+flat in float premultiplied;
 out vec4 colour;
 
 uniform sampler2D sampler;
 
 void main() {
     colour = texture(sampler, tex);
+
+    // We blend with straight alpha, so undo premultiplication for
+    // textures that we rendered into ourselves.
+    if (premultiplied != 0 && colour.a > 0) colour.rgb /= colour.a;
 }
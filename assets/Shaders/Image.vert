@@ -1,11 +1,17 @@
 #version 330 core
 
 layout (location = 0) in vec4 vertex; // vec2 pos, vec2 tex
+layout (location = 2) in vec4 params; // bool premultiplied
 out vec2 tex;
+flat out float premultiplied;
 
-uniform mat4 transform;
+layout(std140) uniform Frame {
+    mat4 projection;
+    vec2 window_size;
+};
 
 void main() {
-    gl_Position = transform * vec4(vertex.xy, 0.0, 1.0);
+    gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
     tex = vertex.zw;
+    premultiplied = params.x;
 }
@@ -1,9 +1,15 @@
 #version 330 core
 
 layout(location = 0) in vec4 vertex;
+layout(location = 1) in vec4 in_colour;
+out vec4 vertex_colour;
 
-uniform mat4 transform;
+layout(std140) uniform Frame {
+    mat4 projection;
+    vec2 window_size;
+};
 
 void main() {
-    gl_Position = transform * vertex;
+    gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
+    vertex_colour = in_colour;
 }
@@ -2,11 +2,10 @@
 
 out vec4 colour;
 in vec2 position;
-
-uniform vec4 in_colour;
-uniform vec2 size;
-uniform mat4 transform;
-uniform float radius; // In pixels.
+flat in vec4 vertex_colour;
+flat in vec2 size;
+flat in float radius; // In pixels.
+flat in vec2 thickness; // If non-zero, only draw an outline this thick.
 
 // How soft the edges should be (in pixels). Higher values could be used to simulate a drop shadow.
 const float edge_softness = .5f;
@@ -19,6 +18,13 @@ float sdf(vec2 p, vec2 sz, float r) {
 
 // Adapted from https://www.shadertoy.com/view/WtdSDs.
 void main() {
+    // Cut out the inside of outlines; only the outer edge is rounded.
+    if (
+        any(greaterThan(thickness, vec2(0))) &&
+        all(greaterThan(position, thickness)) &&
+        all(lessThan(position, size - thickness))
+    ) discard;
+
     // Calculate the distance to the corner of our quadrant.
     vec2 p = position - size / 2.0f;
     float distance = sdf(p, size / 2.0f, radius);
@@ -27,6 +33,6 @@ void main() {
     float a =  1.0f - smoothstep(0.0f, edge_softness * 2.0f, distance);
 
     // Return the resultant shape.
-    colour = vec4(in_colour.rgb, min(a, in_colour.a));
+    colour = vec4(vertex_colour.rgb, min(a, vertex_colour.a));
 }
 
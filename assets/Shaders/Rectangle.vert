@@ -1,14 +1,31 @@
 #version 330 core
 
-layout(location = 0) in vec2 vertex;
+// Per-instance attributes.
+layout(location = 0) in vec4 box; // vec2 pos, vec2 size
+layout(location = 1) in vec4 in_colour;
+layout(location = 2) in vec4 params; // float radius, vec2 thickness
 out vec2 position;
+flat out vec4 vertex_colour;
+flat out vec2 size;
+flat out float radius;
+flat out vec2 thickness;
 
-uniform mat4 transform;
+layout(std140) uniform Frame {
+    mat4 projection;
+    vec2 window_size;
+};
 
 void main() {
-    gl_Position = transform * vec4(vertex.xy, 0.0, 1.0);
+    // We draw a triangle strip of 4 vertices per instance; compute
+    // the corner from the vertex index: (0, 0), (1, 0), (0, 1), (1, 1).
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
 
-    // The box SDF needs to be evaluated before transforms are applied, so
-    // pass along the original position to the vertex shader.
-    position = vertex;
+    // The box SDF is evaluated relative to the rectangle, so pass along
+    // the position within it to the fragment shader.
+    position = corner * box.zw;
+    gl_Position = projection * vec4(box.xy + position, 0.0, 1.0);
+    vertex_colour = in_colour;
+    size = box.zw;
+    radius = params.x;
+    thickness = params.yz;
 }
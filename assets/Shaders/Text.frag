@@ -1,12 +1,17 @@
 #version 330 core
 
 in vec2 tex;
+flat in vec4 text_colour;
 out vec4 colour;
 
 uniform sampler2D sampler;
-uniform vec4 text_colour;
 
 void main() {
-    colour = text_colour * vec4(1.0, 1.0, 1.0, texture(sampler, tex).r);
+    // The atlas contains signed distance fields, where 0.5 is the
+    // outline of the glyph; antialias over about one screen pixel
+    // around it so text stays crisp at any size.
+    float dist = texture(sampler, tex).r;
+    float width = max(fwidth(dist), 1e-4);
+    float alpha = smoothstep(0.5 - width, 0.5 + width, dist);
+    colour = text_colour * vec4(1.0, 1.0, 1.0, alpha);
 }
-
@@ -1,15 +1,29 @@
 #version 330 core
 
-layout (location = 0) in vec4 vertex; // vec2 pos, vec2 tex
+// Per-instance attributes.
+layout (location = 0) in vec4 box; // vec2 pos, vec2 size
+layout (location = 1) in vec4 atlas; // vec2 pos, vec2 size, in texels
+layout (location = 2) in vec4 in_colour;
 out vec2 tex;
+flat out vec4 text_colour;
 
-uniform mat4 transform;
-uniform float atlas_height;
+layout(std140) uniform Frame {
+    mat4 projection;
+    vec2 window_size;
+};
+
+uniform sampler2D sampler;
 
 void main() {
-    gl_Position = transform * vec4(vertex.xy, 0.0, 1.0);
+    // We draw a triangle strip of 4 vertices per glyph; compute
+    // the corner from the vertex index: (0, 0), (1, 0), (0, 1), (1, 1).
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    gl_Position = projection * vec4(box.xy + corner * box.zw, 0.0, 1.0);
 
-    // Atlas width is constant, but the height might change,
-    // so recompute the V coordinate based on the height.
-    tex = vec2(vertex.z, vertex.w / atlas_height);
+    // Glyph bitmaps are stored top to bottom, so flip the V coordinate.
+    // The atlas may grow, so the atlas position is in texels; normalise
+    // it based on the current size.
+    vec2 uv = atlas.xy + vec2(corner.x, 1.0 - corner.y) * atlas.zw;
+    tex = uv / vec2(textureSize(sampler, 0));
+    text_colour = in_colour;
 }
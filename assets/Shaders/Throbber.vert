@@ -2,8 +2,13 @@
 
 layout (location = 0) in vec4 vertex; // vec2 pos
 
+layout(std140) uniform Frame {
+    mat4 projection;
+    vec2 window_size;
+};
+
 uniform float r;
-uniform mat4 transform;
+uniform mat4 model;
 uniform mat4 rotation;
 uniform vec2 position;
 
@@ -16,5 +21,5 @@ void main() {
         1.0
     );
 
-    gl_Position = transform * pos;
+    gl_Position = projection * model * pos;
 }
@@ -6,6 +6,7 @@
 #include <Client/Render/Render.hh>
 #include <Client/UI/UI.hh>
 
+#include <Shared/Allocations.hh>
 #include <Shared/Cards.hh>
 #include <Shared/Constants.hh>
 #include <Shared/Packets.hh>
@@ -14,14 +15,18 @@
 
 #include <base/Base.hh>
 
+#include <chrono>
 #include <functional>
 #include <generator>
 #include <memory>
+#include <optional>
 #include <ranges>
+#include <string>
 #include <thread>
 #include <vector>
 
 namespace pr::client {
+class AllocationOverlay;
 class Client;
 class MenuScreen;
 class ErrorScreen;
@@ -108,6 +113,32 @@ public:
 // =============================================================================
 //  Client
 // =============================================================================
+/// Overlay that shows how much we allocate per frame; this is
+/// only drawn if allocation tracking is enabled.
+class pr::client::AllocationOverlay {
+    /// How often to update the text.
+    static constexpr chr::seconds UpdateInterval{1};
+
+    /// The text to display, and what it should say; the text is
+    /// rebuilt whenever the summary changes.
+    std::optional<Text> text;
+    std::string summary = "Allocations/frame: (measuring)";
+    bool dirty = true;
+
+    /// Allocations since the last update.
+    AllocationStats window{};
+    u64 frames = 0;
+    u64 max_allocations = 0;
+    chr::steady_clock::time_point window_start = chr::steady_clock::now();
+
+public:
+    /// Draw the overlay.
+    void draw(Renderer& r);
+
+    /// Record the allocations made during a frame.
+    void record(const AllocationStats& frame);
+};
+
 class pr::client::Client {
     LIBBASE_IMMOVABLE(Client);
 
@@ -134,6 +165,10 @@ public:
     /// Connexion to the game server.
     net::TCPConnexion server_connexion;
 
+    /// The state of the game we’re in; this is recreated every time
+    /// we connect to a server and sends its packets to it.
+    std::unique_ptr<headless::Game> game;
+
     /// Used by --connect.
     bool autoconfirm_word = false;
 
@@ -141,6 +176,9 @@ private:
     /// Screens that are currently open.
     std::vector<Screen*> screen_stack;
 
+    /// Per-frame allocation statistics.
+    AllocationOverlay allocation_overlay;
+
     explicit Client(Renderer r);
 
 public:
@@ -169,9 +207,8 @@ public:
     /// Show an error to the user.
     void show_error(std::string error, Screen& return_to);
 
-#define X(name) void handle(packets::sc::name);
-    SC_CONFIG_PACKETS(X)
-#undef X
+    /// Start a new game on a connexion to a server and log in.
+    void start_game(net::TCPConnexion conn, std::string username, std::string password);
 
 private:
     static auto Startup() -> Renderer;
@@ -5,6 +5,8 @@
 #include <Client/Render/Render.hh>
 #include <Client/UI/UI.hh>
 
+#include <Headless/Game.hh>
+
 #include <Shared/Cards.hh>
 #include <Shared/Constants.hh>
 #include <Shared/Packets.hh>
@@ -104,17 +106,19 @@ class pr::client::NegationChallengeScreen : public Screen {
 public:
     NegationChallengeScreen(GameScreen& p);
 
-    void enter(packets::sc::PromptNegation p);
+    void enter(CardId negated);
 
 private:
     void Negate(bool negate);
 };
 
 /// This screen renders the actual game.
-class pr::client::GameScreen : public Screen {
-    struct Validator;
+///
+/// The state of the game is kept by the client’s headless::Game; this
+/// screen observes it and updates its widgets to match, after any
+/// effects that are already queued have finished.
+class pr::client::GameScreen : public Screen, public headless::GameObserver {
     class PlayCard;
-    friend Validator;
     friend ConfirmPlaySelectedScreen;
     friend CardChoiceChallengeScreen;
     friend NegationChallengeScreen;
@@ -192,14 +196,31 @@ class pr::client::GameScreen : public Screen {
 
 public:
     explicit GameScreen(Client& c);
-    void enter(packets::sc::StartGame sg);
     void tick(InputSystem& input) override;
 
-#define X(name) void handle(packets::sc::name); void HandleImpl(packets::sc::name);
-    SC_PLAY_PACKETS(X)
-#undef X
+    void on_disconnect(headless::DisconnectReason reason) override;
+    void on_word_choice(const constants::Word& word) override;
+    void on_start_game() override;
+    void on_start_turn() override;
+    void on_end_turn() override;
+    void on_sound_added(PlayerId player, u32 stack_index, CardId card) override;
+    void on_stack_lock_changed(PlayerId player, u32 stack_index, bool locked) override;
+    void on_word_changed(PlayerId player, std::span<const headless::Stack> word) override;
+    void on_card_drawn(CardId card) override;
+    void on_card_removed(u32 card_index) override;
+    void on_hand_discarded() override;
+    void on_card_choice(const packets::CardChoiceChallenge& challenge) override;
+    void on_prompt_negation(CardId card) override;
 
 private:
+    /// Update the UI once the effects that are already queued are done,
+    /// so that changes are shown in the order in which they happened.
+    template <typename Callable>
+    void Apply(Callable c) {
+        if (effect_queue_empty()) c();
+        else Queue(std::move(c));
+    }
+
     void ClearSelection(State new_state = State::NoSelection);
     void ClosePreview();
     void Discard(u32 amount);
@@ -224,7 +245,6 @@ private:
     void TickPassing();
     void TickPlayerTarget();
     void TickSingleTarget();
-    auto ValidatorFor(Player& p) -> Validator;
 };
 
 #endif // PRESCRIPTIVISM_CLIENT_GAME_HH
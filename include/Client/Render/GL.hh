@@ -12,6 +12,7 @@
 #include <glbinding/FunctionCall.h>
 #include <glbinding/gl/gl.h>
 #include <glbinding/glbinding.h>
+#include <glm/ext/vector_uint4_sized.hpp>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -21,11 +22,17 @@
 namespace pr::client {
 using namespace gl;
 
+struct BatchVertex;
+struct GlyphInstance;
+struct RectInstance;
 struct Size;
 
 class DrawableTexture;
+class Framebuffer;
+class GLState;
 class ShaderProgram;
 class Texture;
+class UniformBuffer;
 class VertexArrays;
 class VertexBuffer;
 
@@ -41,6 +48,10 @@ using glm::vec4;
 enum class Axis : u8;
 enum class VertexLayout : u8;
 
+/// The uniform block binding point of the per-frame uniforms; any
+/// shader that declares a uniform block called 'Frame' is bound to it.
+constexpr GLuint FrameUniformBinding = 0;
+
 template <glm::length_t size>
 using Vertices = std::span<const vec<size, f32>>;
 
@@ -76,6 +87,53 @@ struct base::ser::Serialiser<glm::vec<n, T>, E> {
 enum class pr::client::VertexLayout : base::u8 {
     Position2D,        /// vec2f position
     PositionTexture4D, /// vec4f position(xy)+texture(zw)
+    Batch,             /// BatchVertex
+    RectInstance,      /// RectInstance, one per instance
+    GlyphInstance,     /// GlyphInstance, one per instance
+};
+
+/// A vertex as used by the batch renderer.
+///
+/// All batched shaders share this layout so that draws with different
+/// shaders can live in the same buffer.
+struct pr::client::BatchVertex {
+    /// Screen position (xy) and texture coordinates or the position
+    /// relative to the shape being drawn (zw).
+    vec4 position;
+
+    /// The colour of the vertex.
+    vec4 colour;
+
+    /// Shader-specific parameters.
+    vec4 params;
+};
+
+/// A glyph as drawn by the instanced text shader.
+///
+/// Only the screen position needs full precision; the rest is packed
+/// to keep the data we upload for long texts small.
+struct pr::client::GlyphInstance {
+    /// Screen position (xy) and size (zw) of the glyph.
+    vec4 box;
+
+    /// Position (xy) and size (zw) of the glyph in the atlas, in texels.
+    glm::u16vec4 atlas;
+
+    /// The colour of the glyph.
+    glm::u8vec4 colour;
+};
+
+/// A rounded rectangle as drawn by the instanced rectangle shader.
+struct pr::client::RectInstance {
+    /// Screen position (xy) and size (zw) of the rectangle.
+    vec4 box;
+
+    /// The colour of the rectangle.
+    vec4 colour;
+
+    /// Border radius (x) and outline thickness (yz); if the thickness
+    /// is 0, the rectangle is filled.
+    vec4 params;
 };
 
 enum class pr::client::Axis : base::u8 {
@@ -122,8 +180,65 @@ private:
     }
 };
 
+/// Tracks the OpenGL state that changes often during a frame so
+/// we can skip calls that wouldn’t change anything.
+///
+/// All state changes of this kind MUST go through this, or the cache
+/// will get out of sync. There is one of these per thread since a
+/// thread only ever has one current context.
+class pr::client::GLState {
+public:
+    /// Maximum number of texture units we keep track of.
+    static constexpr usz MaxTextureUnits = 8;
+
+    /// Number of OpenGL calls made since these were last reset.
+    struct Counters {
+        u64 calls = 0;   ///< Calls that were actually made.
+        u64 skipped = 0; ///< Calls that were skipped since they were redundant.
+    };
+
+    Counters counters;
+
+private:
+    GLuint program = 0;
+    GLuint vertex_arrays = 0;
+    GLenum active_unit = GL_TEXTURE0;
+    std::array<GLuint, MaxTextureUnits> textures{};
+    bool blend = false;
+
+public:
+    /// Get the state for the current thread.
+    static auto Get() -> GLState&;
+
+    /// Bind a texture to a texture unit and make that unit active.
+    void bind_texture(GLenum unit, GLenum target, GLuint texture);
+
+    /// Bind a vertex array object.
+    void bind_vertex_arrays(GLuint vao);
+
+    /// Forget any bindings of an object that is about to be deleted,
+    /// since its name may be reused for a new object afterwards. Names
+    /// are only unique per object type, so there is one of these for
+    /// every type of object we track.
+    void forget_program(GLuint program);
+    void forget_texture(GLuint texture);
+    void forget_vertex_arrays(GLuint vao);
+
+    /// Enable or disable blending.
+    void set_blend(bool enabled);
+
+    /// Set the active shader program.
+    void use_program(GLuint program);
+
+private:
+    void Skip() { counters.skipped++; }
+};
+
 /// Helper to keep track of and delete OpenGL objects.
-template <auto deleter>
+///
+/// If the bindings of an object are tracked by GLState, \p forget
+/// is the GLState member that must be called before deleting it.
+template <auto deleter, auto forget = nullptr>
 struct Descriptor {
 protected:
     gl::GLuint descriptor{};
@@ -141,6 +256,7 @@ public:
 
     ~Descriptor() {
         if (descriptor) {
+            if constexpr (forget != nullptr) (pr::client::GLState::Get().*forget)(descriptor);
             if constexpr (requires { deleter(1, &descriptor); }) deleter(1, &descriptor);
             else deleter(descriptor);
         }
@@ -152,6 +268,7 @@ class pr::client::VertexBuffer : Descriptor<glDeleteBuffers> {
 
     GLenum draw_mode;
     GLsizei size = 0;
+    GLsizeiptr capacity = 0;
 
     template <typename T>
     VertexBuffer(std::span<const T> data, GLenum draw_mode);
@@ -176,12 +293,24 @@ public:
     template <typename T>
     void store(std::span<const T> data);
 
+    /// Replace the contents of the buffer with data that is only
+    /// going to be drawn once.
+    ///
+    /// This orphans the old storage so we don’t have to wait for the
+    /// GPU to finish drawing from it, and only ever grows the buffer.
+    void stream(std::span<const BatchVertex> data);
+    void stream(std::span<const RectInstance> data);
+    void stream(std::span<const GlyphInstance> data);
+
 private:
     template <typename T>
     void CopyImpl(std::span<const T> data, GLenum usage);
+
+    template <typename T>
+    void StreamImpl(std::span<const T> data);
 };
 
-class pr::client::VertexArrays : Descriptor<glDeleteVertexArrays> {
+class pr::client::VertexArrays : Descriptor<glDeleteVertexArrays, &GLState::forget_vertex_arrays> {
     VertexLayout layout;
     std::vector<VertexBuffer> buffers;
 
@@ -203,16 +332,42 @@ public:
     /// Check if this contains no buffers.
     auto empty() const -> bool { return buffers.empty(); }
 
+    /// Make the vertex attributes start at the given element.
+    ///
+    /// OpenGL 3.3 has no way of specifying the first instance of an
+    /// instanced draw call, so we move the attributes instead. This
+    /// requires that there only be one buffer.
+    void rebase(usz first);
+
     /// Unbinds the vertex array.
     void unbind() const;
 
 private:
     template <typename T>
     auto AddBufferImpl(std::span<const T> verts, GLenum draw_mode) -> VertexBuffer&;
-    void ApplyLayout();
+    void ApplyLayout(usz first = 0);
 };
 
-class pr::client::ShaderProgram : Descriptor<glDeleteProgram> {
+/// A buffer of uniforms that are shared between shaders.
+class pr::client::UniformBuffer : Descriptor<glDeleteBuffers> {
+    GLsizeiptr size;
+
+public:
+    /// Create a buffer of the given size and attach it to a binding point.
+    UniformBuffer(GLsizeiptr size, GLuint binding);
+
+    /// Overwrite the contents of the buffer.
+    ///
+    /// The layout of 'T' must match the std140 layout of the
+    /// uniform block in the shaders.
+    template <typename T>
+    void store(const T& data) { Store(&data, GLsizeiptr(sizeof(T))); }
+
+private:
+    void Store(const void* data, GLsizeiptr bytes);
+};
+
+class pr::client::ShaderProgram : Descriptor<glDeleteProgram, &GLState::forget_program> {
 public:
     ShaderProgram() = default;
 
@@ -232,16 +387,26 @@ public:
     /// Set this as the active shader.
     ///
     /// Prefer to call Renderer::use() instead.
-    void use_shader_program_dont_call_this_directly() const { glUseProgram(descriptor); }
+    void use_shader_program_dont_call_this_directly() const { GLState::Get().use_program(descriptor); }
 
 private:
+    /// Uniform locations; these are looked up once when the program is
+    /// linked. There are only ever a handful of uniforms per shader, so
+    /// a linear search is cheaper than hashing the name.
+    std::vector<std::pair<std::string, GLint>> uniforms;
+
+    void BindUniformBlocks();
+    void CacheUniformLocations();
+
     template <typename... T>
     void SetUniform(ZTermString name, auto callable, T... args);
 };
 
 /// This is an internal handle to texture data. You probably
 /// wand DrawableTexture instead.
-class pr::client::Texture : Descriptor<glDeleteTextures> {
+class pr::client::Texture : Descriptor<glDeleteTextures, &GLState::forget_texture> {
+    friend Framebuffer;
+
     GLenum target{};
     GLenum unit{};
     GLenum format{};
@@ -282,14 +447,22 @@ public:
     /// Bind this texture and make its texture unit active.
     void bind() const;
 
+    /// Make the texture larger, keeping its contents at the origin,
+    /// i.e. texel (0, 0), which is the bottom left corner in OpenGL;
+    /// the rest of the texture is cleared. The copy happens on the GPU,
+    /// so this does not need the texture data.
+    void resize(u32 new_width, u32 new_height);
+
     /// Write data into the texture at a given offset.
     void write(u32 x, u32 y, u32 width, u32 height, const void* data);
 };
 
 class pr::client::DrawableTexture : public Texture {
-    VertexArrays vao{VertexLayout::PositionTexture4D};
-
 public:
+    /// Whether the colour channels are premultiplied by alpha; this
+    /// is the case for textures that we render into.
+    bool premultiplied = false;
+
     DrawableTexture(
         const void* data,
         u32 width,
@@ -323,13 +496,26 @@ public:
     /// texture.
     static auto LoadFromFile(fs::PathRef path) -> DrawableTexture;
 
-    /// Draw the texture.
-    ///
-    /// Prefer to call Renderer::draw_texture() instead.
-    void draw_vertices() const;
-
 private:
     static auto MakeVerts(f32 wd, f32 ht, f32 u, f32 v) -> std::array<vec4, 4>;
 };
 
+/// A framebuffer that renders into a texture.
+///
+/// \see Renderer::push_render_target()
+class pr::client::Framebuffer : Descriptor<glDeleteFramebuffers> {
+    Readonly(Size, size);
+
+public:
+    /// Create a framebuffer that renders into the given texture. The
+    /// texture must outlive the framebuffer.
+    explicit Framebuffer(Texture& texture);
+
+    /// Render into this framebuffer.
+    void bind() const;
+
+    /// Render into the window again.
+    static void BindDefault();
+};
+
 #endif // PRESCRIPTIVISM_CLIENT_RENDER_GL_HH
@@ -14,22 +14,37 @@
 #include <SDL3/SDL_mouse.h>
 #include <SDL3/SDL_video.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <hb.h>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <span>
 #include <stop_token>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
 namespace pr::client {
 struct TextCluster;
+struct ShapedText;
+struct ShapingJob;
+struct TextKey;
 struct Colour;
 struct AABB;
 struct xy;
 
 class AssetLoader;
+class Batcher;
 class Renderer;
 class Font;
+class GlyphAtlas;
+class SkylinePacker;
 class Text;
+class TextCache;
+class TextShaper;
 
 enum struct FontSize : u32;
 enum struct TextAlign : u8;
@@ -37,6 +52,9 @@ enum struct TextStyle : u8;
 enum struct Cursor : u32;
 enum struct Reflow : u8;
 
+using FTLibraryHandle = Handle<FT_Library, FT_Done_FreeType>;
+using FTFaceHandle = Handle<FT_Face, FT_Done_Face>;
+
 template <typename T>
 auto lerp_smooth(T a, T b, f32 t) -> T;
 } // namespace pr::client
@@ -325,59 +343,255 @@ struct std::formatter<pr::client::AABB> : std::formatter<std::string> {
 // =============================================================================
 //  Text
 // =============================================================================
-/// A fixed-sized font, combined with a HarfBuzz shaper and texture atlas.
-class pr::client::Font {
+/// Packs rectangles into a texture atlas.
+///
+/// This keeps track of the ‘skyline’, i.e. the top edge of everything
+/// packed so far, as a list of horizontal segments, and places each new
+/// rectangle wherever its top edge ends up lowest. This wastes very little
+/// space for rectangles of similar height, such as glyphs.
+class pr::client::SkylinePacker {
+    struct Segment {
+        i32 x;
+        i32 y;
+        i32 wd;
+    };
+
+    /// The segments, ordered by x; these always span the entire width.
+    std::vector<Segment> skyline;
+
+    /// The size of the area we’re packing into.
+    Readonly(Size, size);
+
 public:
-    friend AssetLoader;
+    SkylinePacker() = default;
+    explicit SkylinePacker(Size sz);
+
+    /// Grow the area; rectangles that were already packed stay where they are.
+    void grow(Size new_size);
+
+    /// Find space for a rectangle.
+    ///
+    /// \return The position of the rectangle’s bottom left corner, or
+    /// nothing if there is not enough space left.
+    auto pack(Size sz) -> std::optional<xy>;
 
 private:
-    using HarfBuzzFontHandle = Handle<hb_font_t*, hb_font_destroy>;
-    using HarfBuzzBufferHandle = Handle<hb_buffer_t*, hb_buffer_destroy>;
+    auto Fit(usz segment, Size sz) const -> std::optional<i32>;
+};
+
+/// Signed distance fields of the glyphs of a font face.
+///
+/// Glyphs are rasterised once, at a fixed size, as signed distance
+/// fields; the text shader can then render them crisply at any size,
+/// so every font size of a style shares the same atlas.
+///
+/// Glyphs may be added on any thread; they are only copied to the
+/// texture once the main thread asks for it.
+class pr::client::GlyphAtlas {
+    LIBBASE_IMMOVABLE(GlyphAtlas);
+
+public:
+    friend AssetLoader;
+    friend Font;
+
     struct Metrics {
-        LIBBASE_SERIALISE(atlas_index, size, bearing);
+        LIBBASE_SERIALISE(atlas_pos, size, bearing);
+
+        /// Position of the glyph’s distance field in the atlas; this
+        /// includes the spread on all sides.
+        xy atlas_pos;
 
-        u32 atlas_index;
+        /// Size and bearing of the glyph itself at the reference
+        /// size, excluding the spread.
         vec2 size;
         vec2 bearing;
     };
 
-    /// The renderer that owns this font.
-    Readonly(Renderer&, renderer, nullptr);
+    /// The pixel size glyphs are rasterised at.
+    static constexpr i32 ReferenceSize = 48;
 
-    /// HarfBuzz font to use for shaping.
-    HarfBuzzFontHandle hb_font;
+    /// How far the distance field extends past the outline of a
+    /// glyph, in pixels at the reference size.
+    static constexpr i32 Spread = 8;
 
-    /// Font to pull characters from.
+    /// Initial and maximum size of the atlas.
+    static constexpr i32 InitialAtlasSize = 512;
+    static constexpr i32 MaxAtlasSize = 4'096;
+
+private:
+    /// A glyph that has been packed but not uploaded yet.
+    struct PendingGlyph {
+        xy pos;
+        Size size;
+        std::vector<std::byte> bitmap;
+    };
+
+    /// A glyph that has been rasterised but not packed yet.
+    struct Bitmap {
+        Size size;
+        vec2 bearing;
+        std::vector<std::byte> data;
+    };
+
+    /// Threads that rasterise glyphs in parallel; each has a private
+    /// copy of the face since FreeType faces can’t be shared between
+    /// threads. Threads are started on first use and then kept around
+    /// for as long as the atlas exists.
+    class RasteriserPool {
+        LIBBASE_IMMOVABLE(RasteriserPool);
+
+        struct Worker {
+            FTLibraryHandle library;
+            FTFaceHandle face;
+
+            /// The thread MUST be the last member.
+            std::jthread thread;
+        };
+
+        /// The batch that is currently being rasterised.
+        std::mutex mutex;
+        std::condition_variable work_cv;
+        std::condition_variable done_cv;
+        std::span<const FT_UInt> indices;
+        std::span<std::optional<Bitmap>> bitmaps;
+        usz active = 0;    ///< Number of workers taking part in the batch.
+        usz remaining = 0; ///< Number of those that aren’t done yet.
+        u64 generation = 0;
+        bool stop = false;
+
+        /// The workers MUST be the last member.
+        std::vector<std::unique_ptr<Worker>> workers;
+
+    public:
+        RasteriserPool() = default;
+        ~RasteriserPool();
+
+        /// Rasterise glyphs on the given number of threads and wait
+        /// for them to finish.
+        void run(
+            std::span<const char> font_file,
+            std::span<const FT_UInt> glyph_indices,
+            std::span<std::optional<Bitmap>> out,
+            usz threads
+        );
+
+    private:
+        void Work(Worker& w, usz index, u64 seen);
+    };
+
+    /// Minimum number of glyphs that we rasterise on each thread;
+    /// for just a few glyphs, waking threads isn’t worth it.
+    static constexpr usz MinGlyphsPerThread = 16;
+
+    /// Maximum number of threads we rasterise glyphs on.
+    static constexpr usz MaxRasteriserThreads = 8;
+
+    /// Neither FreeType nor HarfBuzz let us use a face on several threads
+    /// at once; this must be held to use the face, or any font created from
+    /// it, and guards everything below except for the texture.
+    std::mutex mutex;
+
+    /// Font to pull glyphs from.
     FT_Face face;
 
-    /// Cached HarfBuzz buffers to use for shaping.
-    std::vector<HarfBuzzBufferHandle> hb_bufs;
-    usz hb_buffers_in_use = 0;
+    /// The font file the face was loaded from, and the threads that
+    /// rasterise glyphs from their own copies of it.
+    std::span<const char> font_file;
+    RasteriserPool rasterisers;
 
-    /// Metrics for all glyphs in the font.
+    /// Size object for the reference size; the face is shared with
+    /// the fonts, each of which has its own size.
+    FT_Size reference_size{};
+
+    /// Metrics for all glyphs in the atlas.
     std::unordered_map<FT_UInt, Metrics> glyphs{};
 
-    /// List of glyphs, in order, that have been added to the atlas; this
-    /// has the same contents as the map, except it’s ordered.
-    std::vector<FT_UInt> glyphs_ordered{};
+    /// Allocates space for glyphs in the atlas; the atlas is as
+    /// large as the packer’s area.
+    SkylinePacker packer{Size{InitialAtlasSize}};
+
+    /// The maximum width and height of the atlas; this is limited
+    /// by the GPU.
+    i32 max_atlas_size = MaxAtlasSize;
+
+    /// Glyphs that still need to be uploaded.
+    std::vector<PendingGlyph> pending;
+
+    /// Set if the texture is out of date; this can be checked
+    /// without taking the lock.
+    std::atomic_bool dirty = false;
+
+    /// The atlas texture; this is only accessed on the main thread.
+    Texture atlas;
+
+public:
+    explicit GlyphAtlas(FT_Face face, std::span<const char> font_file);
+
+    /// Add any glyphs that aren’t in the atlas yet; if there are
+    /// many of them, they are rasterised on several threads.
+    ///
+    /// The caller must hold the lock.
+    void add_glyphs(std::span<const FT_UInt> indices);
+
+    /// Get a glyph, adding it to the atlas if it isn’t there yet.
+    ///
+    /// The caller must hold the lock.
+    auto glyph(FT_UInt index) -> const Metrics&;
+
+    /// Get the atlas texture, uploading any glyphs that were added
+    /// since the last call first. Only call this on the main thread.
+    auto texture() -> const Texture&;
 
-    /// Memory buffer for texture atlas allocation.
-    std::vector<std::byte> atlas_buffer;
+private:
+    /// Add a glyph bitmap to the atlas; returns its position.
+    auto AddGlyph(Size sz, std::vector<std::byte> bitmap) -> std::optional<xy>;
 
-    /// The width and height of a cell in the texture atlas.
-    u32 atlas_entry_width{};
-    u32 atlas_entry_height{};
+    /// Find space for a glyph in the atlas, growing it if need be.
+    auto AllocGlyph(Size sz) -> std::optional<xy>;
 
-    /// The width of the atlas; to prevent glyphs that are already in the
-    /// atlas from moving, we always set the atlas width to the maximum row
-    /// size.
-    u32 atlas_width{};
+    /// Make the atlas larger; returns false if it is already as
+    /// large as it can get.
+    auto GrowAtlas() -> bool;
 
-    /// The number of rows in the texture atlas.
-    u32 atlas_rows{};
+    /// Pack a glyph that was rasterised by Rasterise().
+    auto Insert(FT_UInt index, std::optional<Bitmap> bitmap) -> const Metrics&;
 
-    /// The number of entries in the atlas.
-    u32 atlas_entries{};
+    /// Rasterise a glyph; this doesn’t touch the atlas, so it can be
+    /// called on any thread that has exclusive use of the face.
+    static auto Rasterise(FT_Face face, FT_UInt index) -> std::optional<Bitmap>;
+};
+
+/// A fixed-sized font, combined with a HarfBuzz shaper; the glyphs
+/// themselves are shared with the other sizes of the same style.
+class pr::client::Font {
+public:
+    friend AssetLoader;
+
+private:
+    using HarfBuzzFontHandle = Handle<hb_font_t*, hb_font_destroy>;
+    using HarfBuzzBufferHandle = Handle<hb_buffer_t*, hb_buffer_destroy>;
+    using HarfBuzzShapePlanHandle = Handle<hb_shape_plan_t*, hb_shape_plan_destroy>;
+
+    /// The renderer that owns this font.
+    Readonly(Renderer&, renderer, nullptr);
+
+    /// The atlas that contains the glyphs of this font.
+    GlyphAtlas* glyph_atlas = nullptr;
+
+    /// HarfBuzz font to use for shaping.
+    HarfBuzzFontHandle hb_font;
+
+    /// Shape plan for the language, script, and features we use;
+    /// this saves HarfBuzz from working them out for every line.
+    HarfBuzzShapePlanHandle hb_plan;
+    hb_language_t hb_language{};
+
+    /// Font to pull characters from.
+    FT_Face face;
+
+    /// Cached HarfBuzz buffers to use for shaping.
+    std::vector<HarfBuzzBufferHandle> hb_bufs;
+    usz hb_buffers_in_use = 0;
 
     /// The font size.
     Readonly(FontSize, size);
@@ -394,9 +608,6 @@ private:
     /// Maximum ascender and descender.
     f32 strut_asc{}, strut_desc{};
 
-    /// The atlas texture.
-    Texture atlas;
-
 public:
     i32 x_height{};
 
@@ -406,8 +617,8 @@ private:
 public:
     Font() = default;
 
-    /// Get the size of the font texture.
-    auto atlas_height() const -> i32;
+    /// Get the texture that contains the glyphs of this font.
+    auto atlas() const -> const Texture& { return glyph_atlas->texture(); }
 
     /// Get the bold variant of this font.
     auto bold() -> Font&;
@@ -415,9 +626,6 @@ public:
     /// Get the italic variant of this font.
     auto italic() -> Font&;
 
-    /// Activate the font for rendering.
-    void use() const;
-
     /// Shape text using this font.
     ///
     /// The resulting object is position-independent and can
@@ -427,7 +635,9 @@ public:
     /// that manages caching of the shaped text, as well as any code that
     /// cares about properties computed during shaping, such as cluster
     /// information.
-    void shape(const Text& text, std::vector<TextCluster>* clusters);
+    ///
+    /// This may be called on any thread.
+    auto shape(const TextKey& key, std::vector<TextCluster>* clusters) -> std::shared_ptr<const ShapedText>;
 
     /// Get the font’s strut height.
     auto strut() const -> i32;
@@ -446,10 +656,31 @@ struct pr::client::TextCluster {
     bool operator==(const TextCluster& rhs) const { return index == rhs.index; }
 };
 
+/// The result of shaping a piece of text; this is immutable
+/// and shared by all text objects with the same contents.
+struct pr::client::ShapedText {
+    struct Glyph {
+        /// Bottom left corner of the glyph, relative to the text’s origin.
+        vec2 pos;
+
+        /// Position (xy) and size (zw) of the glyph in the atlas, in texels.
+        glm::u16vec4 atlas;
+    };
+
+    std::vector<Glyph> glyphs;
+
+    /// Size of an atlas texel in pixels at the font size of the text.
+    f32 scale{};
+
+    f32 width{}, height{}, depth{};
+    i32 lines{};
+};
+
 /// A text object that caches the shaping output and vertices needed
 /// to render the text.
 class pr::client::Text {
     friend Font;
+    friend Renderer;
 
     /// The alignment of the text.
     Property(TextAlign, align);
@@ -469,10 +700,10 @@ class pr::client::Text {
     Property(Reflow, reflow, Reflow::None);
 
     /// The number of lines in this text.
-    ComputedReadonly(i32, lines, _lines);
+    ComputedReadonly(i32, lines, shaped ? shaped->lines : 0);
 
     /// Whether this text spans multiple lines.
-    ComputedReadonly(bool, multiline, _lines > 1);
+    ComputedReadonly(bool, multiline, lines > 1);
 
     /// The style of the text (regular, bold, italic).
     ComputedProperty(TextStyle, style, font.style);
@@ -484,22 +715,30 @@ class pr::client::Text {
     ComputedReadonly(bool, empty, content.empty());
 
     /// The horizontal width of the text.
-    ComputedReadonly(f32, width, reshape()._width);
+    ComputedReadonly(f32, width, reshape().shaped->width);
 
     /// The vertical height of the text above the baseline.
-    ComputedReadonly(f32, height, reshape()._height);
+    ComputedReadonly(f32, height, reshape().shaped->height);
 
     /// The vertical depth of the text below the baseline. This
     /// value is positive.
-    ComputedReadonly(f32, depth, reshape()._depth);
+    ComputedReadonly(f32, depth, reshape().shaped->depth);
 
     /// The total size of the text, including depth.
     ComputedReadonly(Size, text_size, Size(i32(width), i32(height + depth)));
 
-    /// Internal state cache.
-    mutable std::optional<VertexArrays> vertices;
-    mutable f32 _width{}, _height{}, _depth{};
-    mutable i32 _lines{};
+    /// Whether this text is still being shaped in the background.
+    ComputedReadonly(bool, pending);
+
+    /// The shaped text; this may be shared with other text objects.
+    mutable std::shared_ptr<const ShapedText> shaped;
+
+    /// What the text looked like before it was last changed; this is
+    /// drawn instead while the text is being shaped in the background.
+    mutable std::shared_ptr<const ShapedText> previous;
+
+    /// The job that is shaping this text in the background, if any.
+    mutable std::shared_ptr<ShapingJob> job;
 
 public:
     /// Use Renderer::text() instead if you want the text to be shaped
@@ -510,24 +749,251 @@ public:
 
     explicit Text(Font& font, std::string_view content, TextAlign align = TextAlign::SingleLine);
 
-    /// Draw the vertices of this text.
-    void draw_vertices() const;
-
     /// Update the text.
     ///
     /// Assign to 'content' instead of calling this directly.
     void set_content(std::string_view new_text);
 
+    /// Shape the text on a worker thread if it isn’t shaped yet.
+    ///
+    /// Querying the size of the text while it is being shaped shapes
+    /// it right away instead; drawing it draws what it looked like
+    /// before it was last changed, or nothing if it has never been
+    /// shaped.
+    ///
+    /// \return True if the text is shaped, false if it isn’t done yet.
+    auto shape_in_background() const -> bool;
+
+    /// Get whatever we can draw right now without shaping the text
+    /// on this thread, if it is being shaped in the background.
+    ///
+    /// Use this instead of the size properties above to position text
+    /// that is about to be drawn, since those shape it immediately.
+    auto drawable() const -> const ShapedText*;
+
 private:
+
+    /// Drop the shaped text after the text was changed.
+    void Invalidate();
+
+    /// Take the result of the background job if it is done.
+    auto PollJob() const -> bool;
+
     auto reshape() const -> const Text&;
 };
 
+/// Everything that affects the result of shaping a text.
+struct pr::client::TextKey {
+    std::u32string content;
+    Font* font;
+    TextAlign align;
+    Reflow reflow;
+    i32 desired_width;
+
+    struct Hash {
+        auto operator()(const TextKey& k) const noexcept -> usz;
+    };
+
+    bool operator==(const TextKey&) const = default;
+};
+
+/// Cache of shaped text, so that text objects with the same contents,
+/// e.g. the names of cards that appear many times, are only shaped and
+/// uploaded once. The least recently used entries are evicted first.
+class pr::client::TextCache {
+    LIBBASE_MOVE_ONLY(TextCache);
+
+    using Entry = std::pair<TextKey, std::shared_ptr<const ShapedText>>;
+
+    /// The maximum number of entries to keep.
+    static constexpr usz MaxEntries = 1'024;
+
+    /// Entries, most recently used first.
+    std::list<Entry> entries;
+    std::unordered_map<TextKey, std::list<Entry>::iterator, TextKey::Hash> index;
+
+public:
+    TextCache() = default;
+
+    /// Look up a text; this makes it the most recently used entry.
+    auto find(const TextKey& key) -> std::shared_ptr<const ShapedText>;
+
+    /// Add text that was shaped elsewhere.
+    void insert(TextKey key, std::shared_ptr<const ShapedText> shaped);
+
+    /// Get the shaped form of a text, shaping it if it isn’t cached.
+    ///
+    /// If clusters are requested, the text is always shaped since
+    /// we don’t cache cluster information.
+    auto shape(const Text& text, std::vector<TextCluster>* clusters) -> std::shared_ptr<const ShapedText>;
+
+    /// Get the key for a text.
+    static auto MakeKey(const Text& text) -> TextKey;
+};
+
+/// Text that is being shaped in the background.
+struct pr::client::ShapingJob {
+    TextKey key;
+
+    /// The shaped text; this is set on the main thread once
+    /// the job is done.
+    std::shared_ptr<const ShapedText> result;
+};
+
+/// Shapes text on a worker thread.
+///
+/// Shaping, and rasterising any glyphs we haven’t seen yet, is the
+/// expensive part of drawing text, so text that is created in bulk,
+/// e.g. when a new hand is dealt, is shaped here to avoid stalling
+/// the frame; only uploading the glyphs happens on the main thread.
+class pr::client::TextShaper {
+    LIBBASE_IMMOVABLE(TextShaper);
+
+    /// Jobs that are waiting to be shaped, and jobs that are done;
+    /// these are shared with the worker.
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::shared_ptr<ShapingJob>> queued;
+    std::vector<std::pair<std::shared_ptr<ShapingJob>, std::shared_ptr<const ShapedText>>> finished;
+    bool stop = false;
+
+    /// Jobs that haven’t been delivered yet, so text objects with
+    /// the same contents share a job. Only accessed on the main thread.
+    std::unordered_map<TextKey, std::shared_ptr<ShapingJob>, TextKey::Hash> in_flight;
+
+    /// The worker MUST be the last member.
+    std::jthread worker;
+
+public:
+    TextShaper();
+    ~TextShaper();
+
+    /// Queue text to be shaped.
+    auto submit(TextKey key) -> std::shared_ptr<ShapingJob>;
+
+    /// Deliver the results of finished jobs and add them to the cache;
+    /// this must be called on the main thread.
+    ///
+    /// \return True if any jobs were delivered.
+    auto poll(TextCache& cache) -> bool;
+
+private:
+    void Run();
+};
+
+// =============================================================================
+//  Batching
+// =============================================================================
+/// Collects draw calls over the course of a frame and submits them
+/// in as few OpenGL draw calls as possible.
+///
+/// Vertices are transformed to screen coordinates on the CPU, so draws
+/// that use the same shader and texture can share a draw call, regardless
+/// of the matrix stack. Draws are grouped into batches in submission order;
+/// a new draw may also be merged into an earlier batch with the same state,
+/// but only if it doesn’t overlap any of the batches in between, since those
+/// would otherwise end up being drawn on top of it.
+class pr::client::Batcher {
+public:
+    /// What a batch is made of.
+    enum struct Kind : u8 {
+        Vertices,
+        Rects,
+        Glyphs,
+    };
+
+    /// The state that all draws in a batch share.
+    struct Key {
+        ShaderProgram* shader;
+        const Texture* texture;
+        GLenum mode;
+        Kind kind = Kind::Vertices;
+
+        bool operator==(const Key&) const = default;
+    };
+
+    /// Screen-space bounding box of a draw.
+    struct Bounds {
+        vec2 min;
+        vec2 max;
+
+        /// Check if this overlaps another box.
+        [[nodiscard]] auto overlaps(const Bounds& other) const -> bool;
+
+        /// Grow this to include another box.
+        void merge(const Bounds& other);
+    };
+
+private:
+    struct Batch {
+        Key key;
+        Bounds bounds;
+        std::vector<BatchVertex> vertices;
+        std::vector<RectInstance> rects;
+        std::vector<GlyphInstance> glyphs;
+    };
+
+    /// How many batches we look back to find one we can merge into.
+    static constexpr usz Lookback = 16;
+
+    /// Batches are reused across frames so their vertex buffers
+    /// don’t need to be reallocated; only the first 'used' are live.
+    std::vector<Batch> batches;
+    usz used = 0;
+
+    /// All vertices, rectangles, and glyphs of the frame, in the order
+    /// they are drawn.
+    std::vector<BatchVertex> staging;
+    std::vector<RectInstance> rect_staging;
+    std::vector<GlyphInstance> glyph_staging;
+
+    /// Created on first use since the constructor runs before
+    /// there is an OpenGL context.
+    std::optional<VertexArrays> vao;
+    std::optional<VertexArrays> rect_vao;
+    std::optional<VertexArrays> glyph_vao;
+    VertexBuffer* vbo = nullptr;
+    VertexBuffer* rect_vbo = nullptr;
+    VertexBuffer* glyph_vbo = nullptr;
+
+public:
+    /// Get the vertex list to add a draw with the given state to.
+    ///
+    /// The vertices must be in screen coordinates and lie within 'bounds'.
+    [[nodiscard]] auto add(const Key& key, const Bounds& bounds) -> std::vector<BatchVertex>&;
+
+    /// Get the list to add a rounded rectangle drawn with the given
+    /// shader to; all rectangles in a batch are drawn in one instanced
+    /// draw call.
+    [[nodiscard]] auto add_rect(ShaderProgram& shader, const Bounds& bounds) -> std::vector<RectInstance>&;
+
+    /// Get the list to add glyphs drawn with the given shader and
+    /// font atlas to; as for rectangles, this is a single instanced
+    /// draw call per batch.
+    [[nodiscard]] auto add_glyphs(ShaderProgram& shader, const Texture& atlas, const Bounds& bounds) -> std::vector<GlyphInstance>&;
+
+    /// Submit all pending draws.
+    void flush();
+
+private:
+    auto Find(const Key& key, const Bounds& bounds) -> Batch&;
+};
+
 // =============================================================================
 //  Renderer
 // =============================================================================
 namespace pr::client {
-using FTLibraryHandle = Handle<FT_Library, FT_Done_FreeType>;
-using FTFaceHandle = Handle<FT_Face, FT_Done_Face>;
+/// Uniforms that are shared by all shaders and change at most once
+/// per frame; this must match the std140 layout of the 'Frame' block
+/// in the shaders.
+struct FrameUniforms {
+    mat4 projection; ///< Maps screen coordinates to clip space.
+    vec2 window_size;
+    vec2 padding{};
+};
+
+static_assert(sizeof(FrameUniforms) == 80, "FrameUniforms must match the std140 layout");
+
 using SDLWindowHandle = Handle<SDL_Window*, SDL_DestroyWindow>;
 using SDLGLContextStateHandle = Handle<SDL_GLContextState*, SDL_GL_DestroyContext>;
 using FontEntry = std::pair<u32, TextStyle>;
@@ -545,6 +1011,7 @@ namespace pr::client {
 struct FontData {
     std::array<FTLibraryHandle, 4> ft{};
     std::array<FTFaceHandle, 4> ft_face{};
+    std::array<std::unique_ptr<GlyphAtlas>, 4> atlases{};
     std::unordered_map<FontEntry, Font> fonts{};
 };
 } // namespace pr::client
@@ -558,14 +1025,17 @@ public:
     /// Load assets; this is an expensive operation and happens
     /// in a separate thread. This does *NOT* create any OpenGL
     /// objects.
-    static auto Create() -> Thread<AssetLoader>;
+    ///
+    /// The glyphs needed to display 'prewarm' are rasterised while
+    /// loading so that we don’t have to when it is first drawn.
+    static auto Create(std::string prewarm) -> Thread<AssetLoader>;
 
     /// Finish loading assets.
     void finalise(Renderer& r);
 
 private:
-    static auto Load(std::stop_token stop) -> AssetLoader;
-    void load(std::stop_token stop);
+    static auto Load(const std::string& prewarm, std::stop_token stop) -> AssetLoader;
+    void load(std::string_view prewarm, std::stop_token stop);
 };
 
 /// A renderer that renders to a window.
@@ -573,6 +1043,7 @@ class pr::client::Renderer {
     LIBBASE_MOVE_ONLY(Renderer);
 
     friend AssetLoader;
+    friend Text;
 
 public:
     class [[nodiscard]] MatrixRAII {
@@ -585,6 +1056,16 @@ public:
         ~MatrixRAII() { r.matrix_stack.pop_back(); }
     };
 
+    class [[nodiscard]] RenderTargetRAII {
+        LIBBASE_IMMOVABLE(RenderTargetRAII);
+        friend Renderer;
+        Renderer& r;
+        explicit RenderTargetRAII(Renderer& r) : r(r) {}
+
+    public:
+        ~RenderTargetRAII() { r.PopRenderTarget(); }
+    };
+
 private:
     SDLWindowHandle window;
     SDLGLContextStateHandle context;
@@ -602,6 +1083,36 @@ private:
     Cursor active_cursor = Cursor::Default;
     Cursor requested_cursor = Cursor::Default;
     std::vector<mat4> matrix_stack;
+    Batcher batcher;
+    TextCache text_cache;
+
+    /// This MUST be declared after the fonts since the worker uses them.
+    std::unique_ptr<TextShaper> text_shaper;
+
+    /// Whether any text that was being shaped in the background was
+    /// delivered at the start of this frame; widgets that were waiting
+    /// for it need to be refreshed.
+    Readonly(bool, text_shaped, false);
+
+    /// Per-frame uniforms; these are shared by all shaders and uploaded
+    /// once at the start of the frame. Created after the context.
+    std::optional<UniformBuffer> frame_uniforms;
+
+    /// How often to log how many OpenGL calls we make.
+    static constexpr u64 GLCallReportIntervalMs = 10'000;
+
+    /// OpenGL calls since the last report.
+    struct {
+        GLState::Counters total;
+        u64 frames = 0;
+        u64 last_report = 0;
+    } gl_calls;
+
+    /// OpenGL calls made during the last frame.
+    Readonly(GLState::Counters, frame_gl_calls);
+
+    /// Whether we’re currently drawing into a framebuffer.
+    bool in_render_target = false;
 
 public:
     class Frame {
@@ -699,6 +1210,12 @@ public:
     /// \see draw_texture(), draw_texture_scaled()
     void draw_texture_sized(const DrawableTexture& tex, AABB box);
 
+    /// Draw part of a texture at a position in world coordinates.
+    ///
+    /// The region is in texels, with (0, 0) at the bottom left, as
+    /// for regions passed to push_render_target().
+    void draw_texture_region(const DrawableTexture& tex, xy pos, AABB region);
+
     /// Get a font of a given size.
     auto font(FontSize size, TextStyle style = TextStyle::Regular) -> Font&;
 
@@ -732,6 +1249,16 @@ public:
     /// we get two rectangles at (100, 100) and (150, 150) respectively.
     auto push_matrix(xy translate, f32 scale = 1) -> MatrixRAII;
 
+    /// Draw into a framebuffer instead of the window.
+    ///
+    /// Everything drawn until the return value goes out of scope ends
+    /// up in 'region' of the framebuffer’s texture, with (0, 0) at the
+    /// bottom left of the region; the region is cleared first. The
+    /// texture ends up with premultiplied alpha.
+    ///
+    /// This cannot be nested.
+    auto push_render_target(Framebuffer& fb, AABB region) -> RenderTargetRAII;
+
     /// Reload all shaders.
     void reload_shaders();
 
@@ -773,13 +1300,61 @@ public:
     ) -> Text;
 
     /// Set the active shader.
+    ///
+    /// This submits any batched draws first since whatever is drawn
+    /// next with this shader must end up on top of them. The current
+    /// matrix, translated by 'position', is passed to the shader as
+    /// the 'model' uniform.
     void use(ShaderProgram& shader, xy position);
 
 private:
+    /// Add vertices to the batch.
+    ///
+    /// 'verts' are relative to 'origin' in the coordinate space of the
+    /// current matrix; only their xy components are transformed, and zw
+    /// is passed to the shader as-is.
+    void Draw(
+        ShaderProgram& shader,
+        const Texture* texture,
+        GLenum mode,
+        xy origin,
+        std::span<const vec4> verts,
+        Colour c,
+        vec4 params = {}
+    );
+
+    /// Add a rounded rectangle to the batch.
+    ///
+    /// If 'thickness' is non-zero, only an outline of that thickness
+    /// along the inside of the rectangle is drawn.
+    void DrawRect(xy pos, Size size, Colour c, i32 border_radius, Size thickness);
+
+    /// Add a quad, given as a triangle strip, to the batch.
+    void DrawQuad(
+        ShaderProgram& shader,
+        const Texture* texture,
+        xy origin,
+        const std::array<vec4, 4>& strip,
+        Colour c,
+        vec4 params = {}
+    );
+
+    /// Submit any batched draws.
+    void Flush();
+
+    /// Stop drawing into a framebuffer.
+    void PopRenderTarget();
+
+    /// Set the viewport and the projection to cover an area of this size.
+    void SetViewport(Size sz);
+
     /// Start/end a frame.
     void frame_end();
     void frame_start();
 
+    /// Update the OpenGL call counters at the end of a frame.
+    void RecordGLCalls();
+
     /// Set the current cursor.
     void SetCursorImpl();
 };
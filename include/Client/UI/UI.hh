@@ -64,6 +64,9 @@ using Hoverable = Selectable;
 
 void InitialiseUI(Renderer& r);
 
+/// Get text whose glyphs we should rasterise at startup.
+auto PrewarmText() -> std::string;
+
 /// Interpolate between two positions.
 ///
 /// If either dimension is set to centered for either position,
@@ -733,6 +736,10 @@ private:
     Colour alternate_colour;
     Image image;
 
+    /// Whether our labels were last laid out with all of their text
+    /// shaped; we don’t cache the card until they were.
+    bool laid_out = false;
+
 public:
     Overlay overlay = Overlay::Default;
     Variant variant = Variant::Regular;
@@ -743,7 +750,13 @@ public:
     void refresh(Renderer&, bool full) override;
 
 private:
+    /// Draw everything that doesn’t change unless the id, scale,
+    /// or variant do.
+    void DrawCard(Renderer& r);
     void DrawChildren(Renderer& r);
+
+    /// Whether any of our text is still being shaped.
+    auto TextPending() const -> bool;
 };
 
 class pr::client::Arrow : public Widget {
@@ -945,7 +958,7 @@ public:
     SelectionMode selection_mode = SelectionMode::Stack;
 
     CardStacks(Element* parent, Position pos) : CardStacks(parent, pos, {}) {}
-    CardStacks(Element* parent, Position pos, std::span<CardId> cards) : Group(parent, pos) {
+    CardStacks(Element* parent, Position pos, std::span<const CardId> cards) : Group(parent, pos) {
         for (auto c : cards) add_stack(c);
     }
 
@@ -0,0 +1,266 @@
+#ifndef PRESCRIPTIVISM_HEADLESS_GAME_HH
+#define PRESCRIPTIVISM_HEADLESS_GAME_HH
+
+#include <Shared/Cards.hh>
+#include <Shared/Constants.hh>
+#include <Shared/Packets.hh>
+#include <Shared/TCP.hh>
+#include <Shared/Utils.hh>
+
+#include <base/Base.hh>
+#include <base/Properties.hh>
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pr::headless {
+class Client;
+class Game;
+class GameObserver;
+struct NegationPrompt;
+struct Player;
+struct Stack;
+struct Validator;
+
+using DisconnectReason = packets::sc::Disconnect::Reason;
+
+/// A card that we can play during our turn.
+using Move = Variant< // clang-format off
+    packets::cs::PlaySingleTarget,
+    packets::cs::PlayPlayerTarget,
+    packets::cs::PlayNoTarget,
+    packets::cs::Pass
+>; // clang-format on
+} // namespace pr::headless
+
+// =============================================================================
+//  Game State
+// =============================================================================
+/// A stack of sound cards in a player’s word.
+struct pr::headless::Stack {
+    std::vector<CardId> cards;
+
+    /// Stack is locked by a spelling reform.
+    bool locked = false;
+
+    [[nodiscard]] auto top() const -> CardId { return cards.back(); }
+    [[nodiscard]] bool full() const { return cards.size() == constants::MaxSoundStackSize; }
+};
+
+/// A player in the game, including us.
+struct pr::headless::Player {
+    PlayerId id;
+    std::string name;
+    std::vector<Stack> word;
+};
+
+/// The server wants to know whether we want to negate a power card.
+struct pr::headless::NegationPrompt {
+    CardId card;
+};
+
+/// Adaptor for the functions in the validation namespace.
+struct pr::headless::Validator {
+    const Player& player;
+    PlayerId us;
+
+    auto operator[](usz i) const -> CardId { return player.word[i].top(); }
+    bool is_own_word() const { return us == player.id; }
+    auto size() const -> usz { return player.word.size(); }
+    bool stack_is_locked(usz i) const { return player.word[i].locked; }
+    bool stack_is_full(usz i) const { return player.word[i].full(); }
+};
+
+/// Interface for anything that wants to react to changes in the
+/// game state, e.g. a bot or a user interface. The game state has
+/// already been updated when any of these are called.
+class pr::headless::GameObserver {
+public:
+    virtual ~GameObserver() = default;
+
+    /// The server has disconnected us.
+    virtual void on_disconnect(DisconnectReason) {}
+
+    /// We need to choose the order of the sounds in our word.
+    virtual void on_word_choice(const constants::Word&) {}
+
+    /// The game has started, or we’ve reconnected to a running game.
+    virtual void on_start_game() {}
+
+    /// It is now our turn.
+    virtual void on_start_turn() {}
+
+    /// Our turn has ended.
+    virtual void on_end_turn() {}
+
+    /// A sound card was added to a stack in a player’s word.
+    virtual void on_sound_added(PlayerId, u32, CardId) {}
+
+    /// A stack in a player’s word was locked or unlocked.
+    virtual void on_stack_lock_changed(PlayerId, u32, bool) {}
+
+    /// A player’s word was replaced entirely.
+    virtual void on_word_changed(PlayerId, std::span<const Stack>) {}
+
+    /// We drew a card.
+    virtual void on_card_drawn(CardId) {}
+
+    /// The card at this index was removed from our hand.
+    virtual void on_card_removed(u32) {}
+
+    /// Our entire hand was discarded.
+    virtual void on_hand_discarded() {}
+
+    /// The server wants us to pick one or more cards.
+    virtual void on_card_choice(const packets::CardChoiceChallenge&) {}
+
+    /// The server wants to know whether we want to negate a power card.
+    virtual void on_prompt_negation(CardId) {}
+};
+
+/// UI-independent client-side model of a game.
+///
+/// This consumes packets sent by the server, keeps track of what
+/// we know about the game (our hand, everyone’s words, whose turn
+/// it is, and any pending challenges), and sends our actions back
+/// to the server.
+///
+/// How packets are sent is up to the owner of this object, so it
+/// can be used with a real connexion or with an in-process one.
+class pr::headless::Game {
+    LIBBASE_IMMOVABLE(Game);
+
+public:
+    enum struct Phase : u8 {
+        LoggingIn,    ///< We’ve sent a login packet, but the game hasn’t started yet.
+        ChoosingWord, ///< We need to submit a word.
+        Waiting,      ///< We’ve submitted our word; waiting for the other players.
+        Running,      ///< The game is in progress.
+        Disconnected, ///< The server has disconnected us.
+    };
+
+    using Challenge = Variant<packets::CardChoiceChallenge, NegationPrompt>;
+    using Sink = std::function<void(std::span<const std::byte>)>;
+
+private:
+    /// Where to send our packets.
+    Sink sink;
+
+    /// The observer that is notified of changes, if any.
+    GameObserver* observer;
+
+    /// Set if the server sent a packet that doesn’t make sense.
+    std::string invalid_packet;
+
+    /// The current phase of the game.
+    Readonly(Phase, phase, Phase::LoggingIn);
+
+    /// Our player id.
+    Readonly(PlayerId, id, 0);
+
+    /// Whether it is our turn.
+    Readonly(bool, our_turn, false);
+
+    /// The word we were dealt at the start of the game.
+    Readonly(constants::Word, dealt_word, {});
+
+    /// The cards in our hand.
+    Readonly(std::vector<CardId>, hand);
+
+    /// All players in the game, in order of player id.
+    Readonly(std::vector<Player>, players);
+
+    /// The challenge we need to reply to, if any.
+    Readonly(std::optional<Challenge>, challenge);
+
+public:
+    explicit Game(Sink sink, GameObserver* observer = nullptr)
+        : sink(std::move(sink)), observer(observer) {}
+
+    /// Reply to the active card choice challenge.
+    void answer_card_choice(std::vector<u32> card_indices);
+
+    /// Reply to the active negation prompt.
+    void answer_negation(bool negate);
+
+    /// Submit our word.
+    void choose_word(const constants::Word& word);
+
+    /// Get all moves that we can make with the cards in our hand. This
+    /// does not include passing.
+    [[nodiscard]] auto legal_moves() const -> std::vector<Move>;
+
+    /// Log in to the server.
+    void login(std::string name, std::string password);
+
+    /// Get a player by id.
+    [[nodiscard]] auto player(PlayerId player) const -> const Player& { return _players[player]; }
+
+    /// Make a move.
+    void play(const Move& move);
+
+    /// Handle all complete packets in a buffer.
+    auto receive(net::ReceiveBuffer& buf) -> Result<>;
+
+    /// Get a validator for a player’s word.
+    [[nodiscard]] auto validator(PlayerId player) const -> Validator {
+        return Validator{_players[player], _id};
+    }
+
+#define X(name) void handle(packets::sc::name);
+    SC_PACKETS(X)
+#undef X
+
+private:
+    /// Check that a packet refers to a stack that exists.
+    bool CheckStack(PlayerId player, u32 stack_index, std::string_view packet);
+
+    template <typename Packet>
+    void Send(const Packet& packet) {
+        if (_phase == Phase::Disconnected) return;
+        sink(ser::Serialise<net::Endianness>(packet));
+    }
+};
+
+// =============================================================================
+//  Client
+// =============================================================================
+/// A headless game client that talks to a server over TCP.
+class pr::headless::Client {
+    LIBBASE_IMMOVABLE(Client);
+
+    net::TCPConnexion conn;
+
+public:
+    /// The game state.
+    Game game;
+
+private:
+    Client(net::TCPConnexion conn, GameObserver* observer);
+
+public:
+    /// Connect to a server and log in.
+    static auto Connect(
+        std::string address,
+        u16 port,
+        std::string name,
+        std::string password,
+        GameObserver* observer = nullptr
+    ) -> Result<std::unique_ptr<Client>>;
+
+    /// Whether we’ve been disconnected.
+    [[nodiscard]] bool disconnected();
+
+    /// Disconnect from the server.
+    void disconnect();
+
+    /// Receive and handle packets from the server; this never blocks.
+    void tick();
+};
+
+#endif // PRESCRIPTIVISM_HEADLESS_GAME_HH
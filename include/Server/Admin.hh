@@ -0,0 +1,140 @@
+#ifndef PRESCRIPTIVISM_SERVER_ADMIN_HH
+#define PRESCRIPTIVISM_SERVER_ADMIN_HH
+
+#include <Shared/Allocations.hh>
+#include <Shared/Packets.hh>
+#include <Shared/Utils.hh>
+
+#include <base/Base.hh>
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace pr::server {
+class AdminServer;
+struct Stats;
+
+/// Number of client-to-server packet types.
+#define X(name) +1
+constexpr usz CSPacketCount = 0 CS_PACKETS(X);
+#undef X
+
+/// Upper bounds of the tick duration histogram buckets, in microseconds;
+/// there is an implicit extra bucket for anything above the last one.
+constexpr std::array<u32, 9> TickHistogramBuckets{
+    1'000,
+    2'000,
+    5'000,
+    10'000,
+    20'000,
+    33'000,
+    50'000,
+    100'000,
+    250'000,
+};
+
+/// Upper bounds of the action duration histogram buckets, in microseconds;
+/// game actions are much cheaper than entire ticks, so these are finer.
+constexpr std::array<u32, 10> ActionHistogramBuckets{
+    10,
+    25,
+    50,
+    100,
+    250,
+    500,
+    1'000,
+    2'500,
+    5'000,
+    10'000,
+};
+} // namespace pr::server
+
+/// Server statistics; these are accumulated by the server
+/// on the tick thread and periodically published to the admin
+/// server, which formats them when someone asks for them.
+struct pr::server::Stats {
+    /// Current state of the game.
+    u32 players = 0;
+    u32 connected_players = 0;
+    u32 connexions = 0;
+    u32 pending_connexions = 0;
+    bool game_running = false;
+
+    /// Number of packets received per type.
+    std::array<u64, CSPacketCount> packets_received{};
+
+    /// Number of bytes waiting to be sent to clients.
+    u64 send_queue_bytes = 0;
+    u64 max_send_queue_bytes = 0;
+
+    /// Number of bytes allocated for connexion buffers.
+    u64 buffer_capacity_bytes = 0;
+
+    /// Number of games that have been played to completion.
+    u64 games_completed = 0;
+
+    /// Tick duration histogram; the buckets are *not* cumulative.
+    std::array<u64, TickHistogramBuckets.size() + 1> tick_histogram{};
+    u64 tick_count = 0;
+    u64 tick_duration_sum = 0; ///< In microseconds.
+
+    /// How long the server took to handle game actions; the buckets
+    /// are *not* cumulative.
+    std::array<u64, ActionHistogramBuckets.size() + 1> action_histogram{};
+    u64 action_count = 0;
+    u64 action_duration_sum = 0; ///< In microseconds.
+
+    /// Allocations made during ticks; these are only counted
+    /// if allocation tracking is enabled.
+    AllocationStats tick_allocations{};
+    AllocationStats last_tick_allocations{};
+
+    /// Record a game action.
+    void record_action(chr::microseconds duration);
+
+    /// Record a tick.
+    void record_tick(chr::microseconds duration, const AllocationStats& allocations);
+};
+
+/// Admin listener that serves a Prometheus-style snapshot of
+/// the server’s statistics over HTTP on a loopback port.
+///
+/// All socket I/O and formatting happens on a separate thread; the
+/// tick thread only ever copies the statistics into the admin server
+/// and never waits for it.
+class pr::server::AdminServer {
+    LIBBASE_IMMOVABLE(AdminServer);
+
+    /// The socket we’re listening on.
+    int listener;
+
+    /// The most recently published statistics.
+    std::mutex mutex;
+    Stats published;
+
+    /// The thread MUST be the last member.
+    std::jthread thread;
+
+    explicit AdminServer(int listener);
+
+public:
+    ~AdminServer();
+
+    /// Start listening on 127.0.0.1 on the given port.
+    static auto Create(u16 port) -> Result<std::unique_ptr<AdminServer>>;
+
+    /// Publish a new set of statistics. This never blocks; if the
+    /// admin thread is currently reading the previous statistics,
+    /// we simply skip this update.
+    void publish(const Stats& stats);
+
+private:
+    void Run(std::stop_token stop);
+    void Serve(int client);
+};
+
+#endif // PRESCRIPTIVISM_SERVER_ADMIN_HH
@@ -0,0 +1,161 @@
+#ifndef PRESCRIPTIVISM_SERVER_EVENTLOG_HH
+#define PRESCRIPTIVISM_SERVER_EVENTLOG_HH
+
+#include <Shared/Packets.hh>
+#include <Shared/TCP.hh>
+#include <Shared/Utils.hh>
+
+#include <base/Base.hh>
+#include <base/Serialisation.hh>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pr::server {
+class EventLog;
+}
+
+// =============================================================================
+//  Schema
+// =============================================================================
+/// Binary event stream written by the server for analytics.
+///
+/// An event log file starts with the Magic bytes and a FileHeader,
+/// followed by any number of records. Each record consists of a
+/// RecordHeader, followed by the event whose type is indicated by
+/// the header. All values are encoded using the same serialisation
+/// format as network packets.
+///
+/// If you change anything here, bump the version number.
+namespace pr::server::events {
+/// Written to the file as raw bytes, i.e. without any byte swapping.
+constexpr std::string_view Magic = "PREVTLOG";
+constexpr u32 Version = 1;
+
+enum struct Type : u8 {
+    RoomCreated,
+    Login,
+    Action,
+    Kick,
+    Tick,
+};
+
+struct FileHeader {
+    LIBBASE_SERIALISE(version);
+    u32 version = Version;
+};
+
+struct RecordHeader {
+    LIBBASE_SERIALISE(type, timestamp);
+    Type type;
+
+    /// Microseconds since the Unix epoch.
+    u64 timestamp;
+};
+
+/// The server has started a game.
+struct RoomCreated {
+    static constexpr Type type = Type::RoomCreated;
+    LIBBASE_SERIALISE(port, max_players);
+    u16 port;
+    u8 max_players;
+};
+
+/// A client has successfully logged in as a player.
+struct Login {
+    static constexpr Type type = Type::Login;
+    LIBBASE_SERIALISE(reconnect, name, address);
+
+    /// Whether this is an existing player reconnecting.
+    bool reconnect;
+    std::string name;
+    std::string address;
+};
+
+/// A player’s game action was applied.
+struct Action {
+    static constexpr Type type = Type::Action;
+    LIBBASE_SERIALISE(player, packet, duration);
+    PlayerId player;
+    packets::cs::ID packet;
+
+    /// How long it took to handle the action, in microseconds.
+    u32 duration;
+};
+
+/// A client was kicked.
+struct Kick {
+    static constexpr Type type = Type::Kick;
+    LIBBASE_SERIALISE(reason, address);
+    packets::common::Disconnect::Reason reason;
+    std::string address;
+};
+
+/// A server tick has finished.
+struct Tick {
+    static constexpr Type type = Type::Tick;
+    LIBBASE_SERIALISE(duration, connexions);
+
+    /// How long the tick took, in microseconds.
+    u32 duration;
+
+    /// How many connexions were open at the end of the tick.
+    u16 connexions;
+};
+
+template <typename T>
+concept Event = requires { { T::type } -> std::convertible_to<Type>; };
+} // namespace pr::server::events
+
+// =============================================================================
+//  Writer
+// =============================================================================
+/// Append-only writer for the event stream.
+///
+/// Events are buffered in memory and handed to a background thread
+/// once per tick, which writes them to disk; the file is synced and
+/// rotated periodically so we never block the tick on disk I/O.
+///
+/// A default-constructed event log discards all events.
+class pr::server::EventLog {
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+
+public:
+    EventLog();
+    EventLog(EventLog&&) noexcept;
+    EventLog& operator=(EventLog&&) noexcept;
+    ~EventLog();
+
+    /// Start writing events to files in the given directory.
+    static auto Open(fs::PathRef directory) -> Result<EventLog>;
+
+    /// Write all events recorded so far to disk and stop the writer
+    /// thread; any events recorded after this are discarded. Call this
+    /// before exiting without running destructors.
+    void close();
+
+    /// Hand all events recorded since the last call to this to the
+    /// writer thread; call this once per tick.
+    void commit();
+
+    /// Record an event.
+    template <events::Event T>
+    void record(const T& event) {
+        if (not impl) return;
+        auto time = chr::system_clock::now().time_since_epoch();
+        Append(ser::Serialise<net::Endianness>(events::RecordHeader{
+            T::type,
+            u64(chr::duration_cast<chr::microseconds>(time).count()),
+        }));
+        Append(ser::Serialise<net::Endianness>(event));
+    }
+
+private:
+    void Append(std::span<const std::byte> data);
+};
+
+#endif // PRESCRIPTIVISM_SERVER_EVENTLOG_HH
@@ -1,6 +1,9 @@
 #ifndef PRESCRIPTIVISM_SERVER_SERVER_HH
 #define PRESCRIPTIVISM_SERVER_SERVER_HH
 
+#include <Server/Admin.hh>
+#include <Server/EventLog.hh>
+
 #include <Shared/Cards.hh>
 #include <Shared/Constants.hh>
 #include <Shared/Packets.hh>
@@ -17,6 +20,7 @@
 #include <random>
 #include <ranges>
 #include <source_location>
+#include <utility>
 #include <vector>
 
 namespace pr::server {
@@ -141,6 +145,9 @@ public:
     /// Remove the currently active challenge.
     void clear_active_challenge();
 
+    /// Close the connexion to this player.
+    void disconnect() { _connexion.disconnect(); }
+
     /// Check if this player has a pending challenge.
     auto has_active_challenge() -> bool { return not challenges.empty(); }
 
@@ -205,6 +212,10 @@ class pr::server::Server : net::TCPServerCallbacks {
     /// List of connexions that have not yet been assigned a player.
     std::vector<PendingConnexion> pending_connexions;
 
+    /// Logins that arrived after the game ended during the current
+    /// tick; these are handled once the next game has been set up.
+    std::vector<std::pair<net::TCPConnexion, packets::cs::Login>> deferred_logins;
+
     /// The password of the server.
     std::string password;
 
@@ -214,9 +225,36 @@ class pr::server::Server : net::TCPServerCallbacks {
 
     State state = State::WaitingForPlayerRegistration;
 
+    /// Whether to start a new game once the current one is over
+    /// instead of exiting.
+    bool keep_running;
+
+    /// Set once the game is over; the next game is set up at the
+    /// start of the next tick.
+    bool game_over = false;
+
+    /// Binary event stream for analytics.
+    EventLog event_log;
+
+    /// Statistics for the admin server.
+    Stats stats;
+
+    /// Admin server, if enabled.
+    std::unique_ptr<AdminServer> admin;
+
 public:
     /// Create and start the server.
-    Server(u16 port, std::string password);
+    Server(
+        u16 port,
+        std::string password,
+        EventLog event_log = {},
+        std::unique_ptr<AdminServer> admin = {},
+        bool keep_running = false
+    );
+
+    /// Add a connexion that didn’t come in through the listening socket,
+    /// e.g. one end of a loopback connexion.
+    void AddConnexion(net::TCPConnexion connexion) { server.add_connexion(std::move(connexion)); }
 
     /// Disconnect a client.
     void Kick(
@@ -228,6 +266,13 @@ public:
     /// Run the server for ever.
     [[noreturn]] void Run();
 
+    /// Reseed the random number generator, e.g. to make a run reproducible.
+    void Seed(u32 seed) { rng.seed(seed); }
+
+    /// Process incoming data and advance the game; Run() calls this
+    /// once per tick.
+    void Tick();
+
 #define X(name) void handle(net::TCPConnexion& client, packets::cs::name);
     CS_PACKETS(X)
 #undef X
@@ -275,9 +320,10 @@ private:
     void RemoveCard(Player& p, Card& c, bool to_discard_pile = true, bool notify = true);
 
     bool PromptNegation(Player& p, CardId power_card);
+    void PublishStats(chr::microseconds tick_duration, const AllocationStats& tick_allocations);
+    void ResetGame();
     void SendGameState(Player& p);
     void SetUpGame();
-    void Tick();
     auto ValidatorFor(Player& p) -> Validator;
 
     auto player() -> Player& { return players[current_player]; }
@@ -0,0 +1,71 @@
+#ifndef PRESCRIPTIVISM_SHARED_ALLOCATIONS_HH
+#define PRESCRIPTIVISM_SHARED_ALLOCATIONS_HH
+
+#include <base/Base.hh>
+
+/// Set this to 1 to replace the global operator new and delete with
+/// versions that keep track of how much we allocate.
+#ifndef PRESCRIPTIVISM_TRACK_ALLOCATIONS
+#    define PRESCRIPTIVISM_TRACK_ALLOCATIONS 0
+#endif
+
+namespace pr {
+using namespace base;
+
+struct AllocationStats;
+class AllocationScope;
+
+/// Whether allocation tracking is enabled.
+constexpr bool AllocationTrackingEnabled = PRESCRIPTIVISM_TRACK_ALLOCATIONS;
+
+/// Get the allocation statistics of the calling thread; these
+/// are only counted if allocation tracking is enabled.
+auto ThreadAllocations() -> AllocationStats;
+
+/// Get the number of bytes currently allocated with operator new
+/// across all threads.
+auto LiveHeapBytes() -> u64;
+} // namespace pr
+
+struct pr::AllocationStats {
+    /// Number of calls to operator new.
+    u64 allocations = 0;
+
+    /// Number of calls to operator delete.
+    u64 deallocations = 0;
+
+    /// Total number of bytes requested from operator new.
+    u64 bytes = 0;
+
+    friend auto operator-(const AllocationStats& a, const AllocationStats& b) -> AllocationStats {
+        return {
+            a.allocations - b.allocations,
+            a.deallocations - b.deallocations,
+            a.bytes - b.bytes,
+        };
+    }
+
+    auto operator+=(const AllocationStats& other) -> AllocationStats& {
+        allocations += other.allocations;
+        deallocations += other.deallocations;
+        bytes += other.bytes;
+        return *this;
+    }
+};
+
+/// Measures the allocations made by the current thread during
+/// the lifetime of this object.
+class pr::AllocationScope {
+    LIBBASE_IMMOVABLE(AllocationScope);
+    AllocationStats start = ThreadAllocations();
+
+public:
+    AllocationScope() = default;
+
+    /// Get the allocations made since this scope was entered.
+    [[nodiscard]] auto delta() const -> AllocationStats {
+        return ThreadAllocations() - start;
+    }
+};
+
+#endif // PRESCRIPTIVISM_SHARED_ALLOCATIONS_HH
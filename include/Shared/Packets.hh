@@ -163,6 +163,7 @@ DefinePacket(Disconnect) {
         UnexpectedPacket, ///< That packet wasn’t supposed to be sent at that point.
         PacketTooLarge,   ///< Packet was too large.
         BufferFull,       ///< Data limit exceeded.
+        GameOver,         ///< The game has ended normally.
     };
 
     Ctor(Disconnect)(Reason reason) : reason(reason) {}
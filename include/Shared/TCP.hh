@@ -14,6 +14,7 @@
 #include <optional>
 #include <span>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace pr::net {
@@ -142,6 +143,12 @@ class pr::net::TCPConnexion {
     /// The address of the remote peer.
     ComputedReadonly(std::string_view, address);
 
+    /// Number of bytes that are waiting to be sent.
+    ComputedReadonly(usz, send_queue_size);
+
+    /// Number of bytes allocated for the send and receive buffers.
+    ComputedReadonly(usz, buffer_capacity);
+
 public:
     TCPConnexion();
     ~TCPConnexion();
@@ -152,6 +159,11 @@ public:
     /// null-termination of the address.
     static auto Connect(std::string remote_address, u16 port) -> Result<TCPConnexion>;
 
+    /// Create a pair of connexions that are connected to each other
+    /// without going through the network, e.g. to feed data to a
+    /// server from within the same process.
+    static auto Loopback() -> Result<std::pair<TCPConnexion, TCPConnexion>>;
+
     /// Close the connexion.
     void disconnect();
 
@@ -202,6 +214,11 @@ public:
     /// Create a server socket that listens on the given port.
     static auto Create(u16 port, u32 max_connexions) -> Result<TCPServer>;
 
+    /// Add a connexion that didn’t come in through the server socket,
+    /// e.g. one end of a loopback connexion. This calls accept() just
+    /// like for any other connexion.
+    void add_connexion(TCPConnexion connexion);
+
     /// Get the connexions that we have accepted.
     auto connexions() -> std::span<TCPConnexion>;
 
@@ -1,19 +1,29 @@
 #ifndef PRESCRIPTIVISM_SHARED_UTILS_HH
 #define PRESCRIPTIVISM_SHARED_UTILS_HH
 
+#include <Shared/Allocations.hh>
+
 #include <base/Base.hh>
 #include <base/Properties.hh>
 
+#include <atomic>
 #include <chrono>
 #include <cstdarg>
+#include <cstring>
 #include <format>
 #include <functional>
 #include <print>
 #include <string>
 #include <thread>
+#include <tuple>
 
 #define FWD(x) std::forward<decltype(x)>(x)
 
+/// Log messages below this level are compiled out entirely.
+#ifndef PRESCRIPTIVISM_MIN_LOG_LEVEL
+#    define PRESCRIPTIVISM_MIN_LOG_LEVEL Trace
+#endif
+
 #define ComputedAccessor(type, name, ...)                                                                              \
 public:                                                                                                                \
     [[nodiscard]] type get_##name() __VA_OPT__({ return) LIBBASE_VA_FIRST(__VA_ARGS__ __VA_OPT__(, );) __VA_OPT__(; }) \
@@ -40,6 +50,37 @@ class Thread;
 
 void CloseLoggingThread();
 
+/// Severity of a log message.
+enum struct LogLevel : u8 {
+    Trace,
+    Debug,
+    Info,
+    Warning,
+    Error,
+};
+
+/// Subsystem that a log message originates from.
+enum struct LogCategory : u8 {
+    General,
+    Net,
+    Game,
+    Render,
+    UI,
+};
+
+constexpr usz LogCategoryCount = usz(LogCategory::UI) + 1;
+constexpr LogLevel MinLogLevel = LogLevel::PRESCRIPTIVISM_MIN_LOG_LEVEL;
+
+/// Set the minimum level of messages to log for every category.
+void SetLogLevel(LogLevel level);
+
+/// Set the minimum level of messages to log for a single category.
+void SetLogLevel(LogCategory category, LogLevel level);
+
+/// Parse a log level name, e.g. ‘warning’.
+auto ParseLogLevel(std::string_view name) -> Result<LogLevel>;
+
+/// Disable all logging while this is alive.
 struct SilenceLog {
     LIBBASE_IMMOVABLE(SilenceLog);
     SilenceLog();
@@ -78,14 +119,71 @@ public:
     void restart() { _start = chr::steady_clock::now(); }
 };
 
-template <typename... Args>
+/// Log a message.
+///
+/// Messages below MinLogLevel are discarded at compile time; messages
+/// below the current level of their category are discarded before we
+/// do any work to format them.
+template <
+    LogLevel level = LogLevel::Info,
+    LogCategory category = LogCategory::General,
+    typename... Args>
 void Log(std::format_string<Args...> fmt, Args&&... args);
 } // namespace pr
 
-namespace pr {
-void LogImpl(std::string);
+namespace pr::detail {
+struct LogRecord;
+struct LogArgWriter;
+struct LogArgReader;
+
+/// Claim the next slot in the logger’s ring buffer; this never blocks
+/// and returns nullptr if the ring is full or the logger has already
+/// been shut down.
+auto LogAcquire() -> LogRecord*;
+
+/// Hand a slot that was claimed by LogAcquire() to the logger thread.
+void LogPublish(LogRecord& rec);
+
+/// Replace the end of a formatted record that didn’t fit in its
+/// buffer with an ellipsis so the truncation is visible.
+void LogMarkTruncated(LogRecord& rec);
+
+/// Capture a message in a slot and publish it.
+template <typename... Args>
+void LogWrite(LogRecord& rec, std::format_string<Args...> fmt, Args&&... args);
+
+/// Runtime log filters; these are only ever accessed with relaxed
+/// loads and stores since it doesn’t matter if a thread sees a stale
+/// value for a while.
+extern constinit std::atomic<LogLevel> LogThresholds[LogCategoryCount];
+extern constinit std::atomic_bool LogEnabled;
+
+/// Check whether a message should be logged.
+[[nodiscard]] inline bool ShouldLog(LogLevel level, LogCategory category) {
+    return LogEnabled.load(std::memory_order::relaxed) and
+           level >= LogThresholds[std::to_underlying(category)].load(std::memory_order::relaxed);
 }
 
+/// Arguments that are copied into the log record as-is.
+template <typename T>
+concept LogScalarArg = std::is_arithmetic_v<T> or std::is_enum_v<T>;
+
+/// Arguments whose characters are copied into the log record.
+template <typename T>
+concept LogStringArg = std::convertible_to<const T&, std::string_view>;
+
+/// Arguments that we can capture without formatting them on the caller
+/// thread; anything else (e.g. types that contain pointers) is formatted
+/// eagerly since we can’t know whether it’ll still be alive by the time
+/// the logger thread gets around to it.
+template <typename T>
+concept LogDeferrableArg = LogScalarArg<T> or LogStringArg<T>;
+
+/// The type a deferred argument is decoded as on the logger thread.
+template <typename T>
+using LogStorage = std::conditional_t<LogStringArg<T>, std::string_view, T>;
+} // namespace pr::detail
+
 namespace base::utils {
 /// Return the last element in a range; this has undefined behaviour
 /// if the range is empty.
@@ -191,11 +289,23 @@ private:
 struct pr::Profile {
     std::string name;
     chr::system_clock::time_point start = chr::system_clock::now();
+    AllocationScope allocations;
     Profile(std::string name) : name(name) {}
     ~Profile() {
         auto end = chr::system_clock::now();
         auto duration = chr::duration_cast<chr::milliseconds>(end - start);
-        std::println("Profile ({}): {}ms", name, duration.count());
+        if constexpr (AllocationTrackingEnabled) {
+            auto a = allocations.delta();
+            std::println(
+                "Profile ({}): {}ms, {} allocations ({} bytes)",
+                name,
+                duration.count(),
+                a.allocations,
+                a.bytes
+            );
+        } else {
+            std::println("Profile ({}): {}ms", name, duration.count());
+        }
     }
 };
 
@@ -271,11 +381,136 @@ public:
     constexpr ZTermString(const char (&str)[n]) : data(str, n - 1) {}
 
     auto c_str() const -> const char* { return data.data(); }
+    auto sv() const -> std::string_view { return data; }
+};
+
+// =============================================================================
+//  Logging
+// =============================================================================
+/// A preallocated entry in the logger’s ring buffer.
+///
+/// Format arguments are captured in binary form and only formatted
+/// on the logger thread; if that isn’t possible, the message is instead
+/// formatted directly into the buffer on the caller thread.
+struct pr::detail::LogRecord {
+    static constexpr usz BufferSize = 256;
+    using Formatter = void(std::string& out, std::string_view fmt, const std::byte* args);
+
+    enum struct Kind : u8 {
+        Formatted, ///< The buffer contains the message text.
+        Deferred,  ///< The buffer contains the format arguments.
+        Stop,      ///< Sentinel that shuts down the logger thread.
+    };
+
+    /// Synchronises access to this slot; see Utils.cc.
+    std::atomic<u64> sequence;
+    u64 ticket;
+    chr::system_clock::time_point time;
+    std::string_view fmt;
+    Formatter* format;
+    u32 size;
+    Kind kind;
+    LogLevel level;
+    LogCategory category;
+    std::byte buffer[BufferSize];
+};
+
+struct pr::detail::LogArgWriter {
+    std::byte* ptr;
+    std::byte* end;
+
+    [[nodiscard]] bool write(const void* data, usz n) {
+        if (usz(end - ptr) < n) return false;
+        std::memcpy(ptr, data, n);
+        ptr += n;
+        return true;
+    }
+
+    template <typename T>
+    [[nodiscard]] bool operator()(const T& t) {
+        if constexpr (LogStringArg<T>) {
+            std::string_view sv = t;
+            u32 sz = u32(sv.size());
+            return write(&sz, sizeof sz) and write(sv.data(), sv.size());
+        } else {
+            return write(&t, sizeof(T));
+        }
+    }
+};
+
+struct pr::detail::LogArgReader {
+    const std::byte* ptr;
+
+    template <typename T>
+    auto read() -> T {
+        if constexpr (std::is_same_v<T, std::string_view>) {
+            u32 sz;
+            std::memcpy(&sz, ptr, sizeof sz);
+            std::string_view sv{reinterpret_cast<const char*>(ptr + sizeof sz), sz};
+            ptr += sizeof sz + sz;
+            return sv;
+        } else {
+            T t;
+            std::memcpy(&t, ptr, sizeof(T));
+            ptr += sizeof(T);
+            return t;
+        }
+    }
 };
 
+namespace pr::detail {
 template <typename... Args>
+void FormatDeferred(std::string& out, std::string_view fmt, const std::byte* data) {
+    // Braced initialisation guarantees left-to-right evaluation.
+    LogArgReader r{data};
+    std::tuple<LogStorage<Args>...> args{r.template read<LogStorage<Args>>()...};
+    std::apply(
+        [&](auto&... a) { std::vformat_to(std::back_inserter(out), fmt, std::make_format_args(a...)); },
+        args
+    );
+}
+} // namespace pr::detail
+
+template <pr::LogLevel level, pr::LogCategory category, typename... Args>
 void pr::Log(std::format_string<Args...> fmt, Args&&... args) {
-    pr::LogImpl(std::format(fmt, std::forward<Args>(args)...));
+    if constexpr (level < MinLogLevel) return;
+    else {
+        if (not detail::ShouldLog(level, category)) return;
+        auto rec = detail::LogAcquire();
+        if (not rec) return;
+        rec->time = chr::system_clock::now();
+        rec->level = level;
+        rec->category = category;
+        detail::LogWrite(*rec, fmt, std::forward<Args>(args)...);
+    }
+}
+
+template <typename... Args>
+void pr::detail::LogWrite(LogRecord& rec, std::format_string<Args...> fmt, Args&&... args) {
+    // Capture the arguments if we can.
+    if constexpr ((LogDeferrableArg<std::remove_cvref_t<Args>> and ...)) {
+        LogArgWriter w{rec.buffer, rec.buffer + rec.BufferSize};
+        if ((w(args) and ...)) {
+            rec.kind = LogRecord::Kind::Deferred;
+            rec.fmt = fmt.get();
+            rec.format = &FormatDeferred<std::remove_cvref_t<Args>...>;
+            return LogPublish(rec);
+        }
+    }
+
+    // Otherwise, format the message into the record; this will truncate
+    // it if it’s too long, but it never allocates.
+    auto res = std::format_to_n(
+        reinterpret_cast<char*>(rec.buffer),
+        isz(rec.BufferSize),
+        fmt,
+        std::forward<Args>(args)...
+    );
+
+    rec.kind = LogRecord::Kind::Formatted;
+    if (res.size <= isz(rec.BufferSize)) rec.size = u32(res.size);
+    else LogMarkTruncated(rec);
+    LogPublish(rec);
 }
 
 #pragma clang diagnostic push
@@ -139,8 +139,7 @@ void ConnexionScreen::tick(InputSystem& input) {
             }
 
             // We do! Tell the server who we are and switch to game screen.
-            client.server_connexion = std::move(conn.value());
-            client.server_connexion.send(cs::Login(std::move(username), std::move(password)));
+            client.start_game(std::move(conn.value()), std::move(username), std::move(password));
             client.set_screen(client.waiting_screen);
             return;
         }
@@ -192,7 +191,7 @@ void WordChoiceScreen::SendWord() {
 
     // Validate the word; if it is valid, submit it.
     if (validation::ValidateInitialWord(w, original_word) == Valid) {
-        client.server_connexion.send(cs::WordChoice{w});
+        client.game->choose_word(w);
         client.set_screen(client.waiting_screen);
         return;
     }
@@ -262,52 +261,70 @@ void WordChoiceScreen::tick(InputSystem& input) {
 }
 
 // =============================================================================
-//  Game Screen - Packet Handlers
+//  Networking
 // =============================================================================
-void Client::handle(sc::Disconnect packet) {
-    server_connexion.disconnect();
-    auto reason = [&] -> std::string_view {
-        switch (packet.reason) {
-            using Reason = sc::Disconnect::Reason;
-            case Reason::Unspecified: return "Disconnected";
-            case Reason::ServerFull: return "Disconnected: Server full";
-            case Reason::InvalidPacket: return "Disconnected: Client sent invalid packet";
-            case Reason::UsernameInUse: return "Disconnected: User name already in use";
-            case Reason::WrongPassword: return "Disconnected: Invalid Password";
-            case Reason::UnexpectedPacket: return "Disconnected: Unexpected Packet";
-            case Reason::PacketTooLarge: return "Disconnected: Packet too large";
-            case Reason::BufferFull: return "Disconnected: Data limit exceeded";
-            default: return "Disconnected: <<<Invalid>>>";
-        }
-    }();
-    show_error(std::string{reason}, menu_screen);
-}
+void Client::start_game(net::TCPConnexion conn, std::string username, std::string password) {
+    server_connexion = std::move(conn);
+    game = std::make_unique<headless::Game>(
+        [this](std::span<const std::byte> data) { server_connexion.send(data); },
+        &game_screen
+    );
 
-void Client::handle(sc::HeartbeatRequest req) {
-    server_connexion.send(cs::HeartbeatResponse{req.seq_no});
+    game->login(std::move(username), std::move(password));
 }
 
-void Client::handle(sc::StartGame sg) { game_screen.enter(std::move(sg)); }
-void Client::handle(sc::WordChoice wc) { word_choice_screen.enter(wc.word); }
-
 void Client::TickNetworking() {
     if (server_connexion.disconnected) return;
     server_connexion.receive([&](net::ReceiveBuffer& buf) {
-        while (not server_connexion.disconnected and not buf.empty()) {
-            auto res = packets::HandleClientSidePacket(*this, game_screen, buf);
-
-            // If there was an error, close the connexion.
-            if (not res) {
-                server_connexion.disconnect();
-                show_error(res.error(), menu_screen);
-            }
-
-            // And stop if the packet was incomplete.
-            if (not res.value()) break;
+        // If there was an error, close the connexion.
+        if (auto res = game->receive(buf); not res) {
+            server_connexion.disconnect();
+            show_error(res.error(), menu_screen);
         }
     });
 }
 
+// =============================================================================
+//  Allocation Overlay
+// =============================================================================
+void AllocationOverlay::draw(Renderer& r) {
+    static constexpr i32 Padding = 5;
+    if (dirty or not text) {
+        dirty = false;
+        text.emplace(r.text(summary, FontSize::Small));
+    }
+
+    // Draw this in the top-left corner.
+    auto sz = text->text_size;
+    auto pos = xy{Padding, r.size().ht - sz.ht - 3 * Padding};
+    r.draw_rect(pos, Size{sz.wd + 2 * Padding, sz.ht + 2 * Padding}, Colour{0, 0, 0, 160});
+    r.draw_text(*text, pos + xy{Padding, Padding + i32(text->depth)});
+}
+
+void AllocationOverlay::record(const AllocationStats& frame) {
+    window += frame;
+    frames++;
+    max_allocations = std::max(max_allocations, frame.allocations);
+
+    // Only update the text every once in a while so it’s actually
+    // readable; we display the stats of the previous window while
+    // we collect the next one.
+    auto now = chr::steady_clock::now();
+    if (now - window_start < UpdateInterval) return;
+    summary = std::format(
+        "Allocations/frame: {} avg, {} max, {} bytes avg",
+        window.allocations / frames,
+        max_allocations,
+        window.bytes / frames
+    );
+
+    dirty = true;
+    window = {};
+    frames = 0;
+    max_allocations = 0;
+    window_start = now;
+}
+
 // =============================================================================
 //  API
 // =============================================================================
@@ -320,7 +337,8 @@ Client::Client(Renderer r) : renderer(std::move(r)) {
 
     // For testing.
     sc::StartGame sg{pi, {CardId::P_SpellingReform, CardId::P_Chomsky, CardId::V_u}, 0};
-    game_screen.enter(sg);
+    game = std::make_unique<headless::Game>([](auto) {}, &game_screen);
+    game->handle(sg);
     */
     push_screen(menu_screen);
 }
@@ -360,6 +378,8 @@ void Client::set_screen(Screen& s) {
 }
 
 void Client::Tick() {
+    AllocationScope frame_allocations;
+
     // Handle networking.
     TickNetworking();
 
@@ -378,7 +398,11 @@ void Client::Tick() {
             s->draw(renderer);
             if (s != screen_stack.back()) renderer.draw_rect(xy{}, renderer.size(), Veil);
         }
+
+        if constexpr (AllocationTrackingEnabled) allocation_overlay.draw(renderer);
     }
+
+    if constexpr (AllocationTrackingEnabled) allocation_overlay.record(frame_allocations.delta());
 }
 
 void Client::RunGame() {
@@ -397,7 +421,7 @@ auto Client::Startup() -> Renderer {
     // fact that we don’t have the required assets yet.
     Renderer r{1'800, 1'000};
     Screen screen{r};
-    Thread asset_loader{AssetLoader::Create()};
+    Thread asset_loader{AssetLoader::Create(PrewarmText())};
     InputSystem startup{r};
     screen.Create<Throbber>(Position::Center());
 
@@ -15,24 +15,6 @@ using namespace pr::client;
 namespace sc = packets::sc;
 namespace cs = packets::cs;
 
-// =============================================================================
-// Validation
-// =============================================================================
-struct GameScreen::Validator {
-    const Player& cs;
-    PlayerId us;
-
-    auto operator[](usz i) const -> CardId { return cs.word->stacks()[i].top.id; }
-    bool is_own_word() const { return us == cs.id; }
-    auto size() const -> usz { return cs.word->stacks().size(); }
-    bool stack_is_locked(usz i) const { return cs.word->stacks()[i].locked; }
-    bool stack_is_full(usz i) const { return cs.word->stacks()[i].full; }
-};
-
-auto GameScreen::ValidatorFor(Player& p) -> Validator {
-    return Validator{p, us.id};
-}
-
 // =============================================================================
 // Card Preview.
 // =============================================================================
@@ -223,10 +205,10 @@ void CardChoiceChallengeScreen::tick(InputSystem& input) {
 }
 
 void CardChoiceChallengeScreen::Confirm() { // clang-format off
-    cs::CardChoiceReply choice = selected
+    auto choice = selected
         | vws::transform([&](Card* c) { return cards->index_of(c->parent.as<CardStacks::Stack>()).value(); })
         | rgs::to<std::vector>();
-    parent.client.server_connexion.send(choice);
+    parent.client.game->answer_card_choice(std::move(choice));
     parent.client.pop_screen();
 } // clang-format on
 
@@ -253,14 +235,14 @@ NegationChallengeScreen::NegationChallengeScreen(GameScreen& p) : Screen(p.rende
 }
 
 void NegationChallengeScreen::Negate(bool negate) {
-    parent.client.server_connexion.send(cs::PromptNegationReply{negate});
+    parent.client.game->answer_negation(negate);
     parent.client.pop_screen();
 }
 
-void NegationChallengeScreen::enter(sc::PromptNegation p) {
-    card->id = p.card_id;
+void NegationChallengeScreen::enter(CardId negated) {
+    card->id = negated;
     parent.client.push_screen(*this);
-    prompt->update_text(std::format("Use Negation to protect yourself from {}?", CardDatabase[+p.card_id].name));
+    prompt->update_text(std::format("Use Negation to protect yourself from {}?", CardDatabase[+negated].name));
 }
 
 // =============================================================================
@@ -287,7 +269,7 @@ void GameScreen::ClosePreview() {
 void GameScreen::Discard(base::u32 amount) {
     // 0 means discard the entire hand.
     if (amount == 0) our_hand->clear();
-    else Log("TODO: Implement discarding {} cards", amount);
+    else Log<LogLevel::Warning, LogCategory::Game>("TODO: Implement discarding {} cards", amount);
 }
 
 void GameScreen::Discard(CardStacks::Stack& stack) {
@@ -361,11 +343,14 @@ void GameScreen::SwapSelectedCard() {
 }
 
 auto GameScreen::Targets(Card& c) -> std::generator<Target> {
+    // Validate against the game state rather than what is on the screen;
+    // the latter may lag behind while effects are playing.
+    auto& game = *client.game;
     auto YieldStacksFromAll = [&](auto pred) -> std::generator<Target> {
         for (auto p : all_players) {
-            auto v = ValidatorFor(*p);
+            auto v = game.validator(p->id);
             for (auto [i, s] : p->word->stacks() | vws::enumerate)
-                if (pred(v, i))
+                if (usz(i) < v.size() and pred(v, i))
                     co_yield Target{s};
         }
     };
@@ -388,9 +373,9 @@ auto GameScreen::Targets(Card& c) -> std::generator<Target> {
             break;
 
         case CardIdValue::P_SpellingReform: {
-            auto v = ValidatorFor(us);
+            auto v = game.validator(us.id);
             for (auto [i, s] : us.word->stacks() | vws::enumerate)
-                if (validation::ValidateP_SpellingReform(v, i))
+                if (usz(i) < v.size() and validation::ValidateP_SpellingReform(v, i))
                     co_yield Target{s};
         } break;
     }
@@ -399,44 +384,56 @@ auto GameScreen::Targets(Card& c) -> std::generator<Target> {
 }
 
 // =============================================================================
-// Packet Handlers
+// Game Observer
 // =============================================================================
-#define X(name)                                                                               \
-    void GameScreen::handle(packets::sc::name packet) {                                       \
-        if (effect_queue_empty()) {                                                           \
-            HandleImpl(std::move(packet));                                                    \
-            return;                                                                           \
-        }                                                                                     \
-                                                                                              \
-        Queue([this, packet = std::move(packet)] mutable { HandleImpl(std::move(packet)); }); \
-    }
-SC_PLAY_PACKETS(X)
-#undef X
+void GameScreen::on_disconnect(headless::DisconnectReason r) {
+    client.server_connexion.disconnect();
+    auto reason = [&] -> std::string_view {
+        switch (r) {
+            using Reason = headless::DisconnectReason;
+            case Reason::Unspecified: return "Disconnected";
+            case Reason::ServerFull: return "Disconnected: Server full";
+            case Reason::InvalidPacket: return "Disconnected: Client sent invalid packet";
+            case Reason::UsernameInUse: return "Disconnected: User name already in use";
+            case Reason::WrongPassword: return "Disconnected: Invalid Password";
+            case Reason::UnexpectedPacket: return "Disconnected: Unexpected Packet";
+            case Reason::PacketTooLarge: return "Disconnected: Packet too large";
+            case Reason::BufferFull: return "Disconnected: Data limit exceeded";
+            case Reason::GameOver: return "Game over: No more plays can be made";
+            default: return "Disconnected: <<<Invalid>>>";
+        }
+    }();
+    client.show_error(std::string{reason}, client.menu_screen);
+}
 
-void GameScreen::HandleImpl(sc::AddSoundToStack add) {
-    auto& player = PlayerById(add.player);
-    player.word->stacks()[add.stack_index].push(add.card);
+void GameScreen::on_word_choice(const constants::Word& word) {
+    client.word_choice_screen.enter(word);
 }
 
-void GameScreen::HandleImpl(sc::CardChoice c) {
-    packets::CardChoiceChallenge c1 = std::move(c.challenge);
-    card_choice_challenge_screen.enter(std::move(c1));
+void GameScreen::on_sound_added(PlayerId player, u32 stack_index, CardId card) {
+    Apply([=, this] { PlayerById(player).word->stacks()[stack_index].push(card); });
 }
 
-void GameScreen::HandleImpl(sc::Draw dr) {
-    our_hand->add_stack(dr.card);
-    ResetHand();
+void GameScreen::on_card_choice(const packets::CardChoiceChallenge& challenge) {
+    Apply([this, challenge] { card_choice_challenge_screen.enter(challenge); });
 }
 
-void GameScreen::HandleImpl(sc::DiscardAll) {
-    Discard(0);
+void GameScreen::on_card_drawn(CardId card) {
+    Apply([this, card] {
+        our_hand->add_stack(card);
+        ResetHand();
+    });
 }
 
-void GameScreen::HandleImpl(sc::EndTurn) {
-    EndTurn();
+void GameScreen::on_hand_discarded() {
+    Apply([this] { Discard(0); });
 }
 
-void GameScreen::HandleImpl(sc::RemoveCard r) {
+void GameScreen::on_end_turn() {
+    Apply([this] { EndTurn(); });
+}
+
+void GameScreen::on_card_removed(u32 card_index) {
     // TODO: Show message to the user. This is only used when a card
     //       is removed via some effect, so show e.g. ‘One of your cards has
     //       been stolen!’ on the screen or sth like that.
@@ -444,32 +441,35 @@ void GameScreen::HandleImpl(sc::RemoveCard r) {
     //       In general, we need some API for flashing a message on the screen
     //       above everything else (including every open screen). Probably put
     //       that in the Client class.
-    our_hand->remove(r.card_index);
+    Apply([this, card_index] { our_hand->remove(card_index); });
 }
 
-void GameScreen::HandleImpl(sc::StackLockChanged lock) {
-    auto& p = PlayerById(lock.player);
-    p.word->stacks()[lock.stack_index].locked = lock.locked;
+void GameScreen::on_stack_lock_changed(PlayerId player, u32 stack_index, bool locked) {
+    Apply([=, this] { PlayerById(player).word->stacks()[stack_index].locked = locked; });
 }
 
-void GameScreen::HandleImpl(sc::StartTurn) {
-    state = State::NoSelection;
-    end_turn_button->selectable = Selectable::Yes;
-    ResetHand();
-    // TODO: Automatically go into passing mode if we cannot play anything in our hand.
+void GameScreen::on_start_turn() {
+    Apply([this] {
+        state = State::NoSelection;
+        end_turn_button->selectable = Selectable::Yes;
+        ResetHand();
+        // TODO: Automatically go into passing mode if we cannot play anything in our hand.
+    });
 }
 
-void GameScreen::HandleImpl(sc::WordChanged wc) {
-    auto& p = PlayerById(wc.player);
-    p.word->clear();
-    for (auto& s : wc.new_word) {
-        auto& stack = p.word->add_stack();
-        for (auto c : s) stack.push(c);
-    }
+void GameScreen::on_word_changed(PlayerId player, std::span<const headless::Stack> word) {
+    Apply([this, player, word = std::vector(word.begin(), word.end())] {
+        auto& p = PlayerById(player);
+        p.word->clear();
+        for (auto& s : word) {
+            auto& stack = p.word->add_stack();
+            for (auto c : s.cards) stack.push(c);
+        }
+    });
 }
 
-void GameScreen::HandleImpl(sc::PromptNegation p) {
-    negation_challenge_screen.enter(p);
+void GameScreen::on_prompt_negation(CardId card) {
+    Apply([this, card] { negation_challenge_screen.enter(card); });
 }
 
 // =============================================================================
@@ -504,7 +504,7 @@ void GameScreen::Pass() {
 void GameScreen::PlayCardWithoutTarget() {
     Assert(our_selected_card, "No card selected?");
     auto [stack, idx] = GetStackInHand(*our_selected_card);
-    client.server_connexion.send(cs::PlayNoTarget{idx});
+    client.game->play(cs::PlayNoTarget{idx});
     Queue<PlayCard>(*our_selected_card);
 }
 
@@ -556,7 +556,7 @@ void GameScreen::TickNotOurTurn() {}
 void GameScreen::TickPassing() {
     if (not selected_element) return;
     auto [stack, idx] = GetStackInHand(selected_element->as<Card>());
-    client.server_connexion.send(cs::Pass{idx});
+    client.game->play(cs::Pass{idx});
     end_turn_button->update_text("Pass");
 
     /// Make sure the user can’t press the pass button again (and the server
@@ -575,13 +575,13 @@ void GameScreen::TickPlayerTarget() {
     auto& p = SelectedPlayer();
     switch (our_selected_card->id.value) {
         default:
-            Log("TODO: Implement {}", CardDatabase[+our_selected_card->id].name);
+            Log<LogLevel::Warning, LogCategory::Game>("TODO: Implement {}", CardDatabase[+our_selected_card->id].name);
             ClearSelection();
             break;
 
         case CardIdValue::P_Superstratum: {
             auto [stack, idx] = GetStackInHand(*our_selected_card);
-            client.server_connexion.send(cs::PlayPlayerTarget{idx, p.id});
+            client.game->play(cs::PlayPlayerTarget{idx, p.id});
             Queue<PlayCard>(*our_selected_card);
         } break;
     }
@@ -600,7 +600,7 @@ void GameScreen::TickSingleTarget() {
         auto& our_stack = our_selected_card->parent.as<CardStacks::Stack>();
         auto card_in_hand_index = our_hand->index_of(our_stack);
         auto selected_card_index = owner->word->index_of(stack);
-        client.server_connexion.send(cs::PlaySingleTarget{
+        client.game->play(cs::PlaySingleTarget{
             card_in_hand_index.value(),
             owner->id,
             selected_card_index.value(),
@@ -626,24 +626,31 @@ void GameScreen::TickSingleTarget() {
                 PlaySingleTarget();
                 return;
             default:
-                Log("TODO: Implement {}", CardDatabase[+our_selected_card->id].name);
+                Log<LogLevel::Warning, LogCategory::Game>("TODO: Implement {}", CardDatabase[+our_selected_card->id].name);
                 ClearSelection();
                 break;
         }
     }
 }
 
-void GameScreen::enter(sc::StartGame sg) {
+void GameScreen::on_start_game() {
+    auto& game = *client.game;
     DeleteAllChildren();
 
+    // The words in the game state are made up of stacks; at the start of
+    // the game, those only contain the original card.
+    auto TopCards = [](const headless::Player& p) {
+        return p.word | vws::transform(&headless::Stack::top) | rgs::to<std::vector>();
+    };
+
     end_turn_button = &Create<Button>("Pass", Position(-50, 50), [&] { Pass(); });
     other_players.clear();
     other_words = &Create<Group>(Position());
-    for (auto [i, p] : sg.player_data | vws::enumerate) {
-        if (i == sg.player_id) {
-            us = Player("You", sg.player_id);
-            us.word = &Create<CardStacks>(Position(), p.word);
-            our_hand = &Create<CardStacks>(Position(), sg.hand);
+    for (auto& p : game.players) {
+        if (p.id == game.id) {
+            us = Player("You", p.id);
+            us.word = &Create<CardStacks>(Position(), TopCards(p));
+            our_hand = &Create<CardStacks>(Position(), game.hand);
             our_hand->scale = Card::Hand;
             our_hand->gap = -Card::CardSize[Card::Hand].wd / 2;
             our_hand->selection_mode = CardStacks::SelectionMode::Card;
@@ -652,10 +659,10 @@ void GameScreen::enter(sc::StartGame sg) {
             continue;
         }
 
-        auto& op = other_players.emplace_back(std::move(p.name), u8(i));
+        auto& op = other_players.emplace_back(p.name, p.id);
         auto& word_and_name = other_words->create<Group>(Position());
         word_and_name.vertical = true;
-        op.word = &word_and_name.create<CardStacks>(Position(), p.word);
+        op.word = &word_and_name.create<CardStacks>(Position(), TopCards(p));
         op.word->scale = Card::OtherPlayer;
         op.word->alignment = -5;
         op.name_widget = &word_and_name.create<Label>(op.name, FontSize::Medium, Position());
@@ -12,6 +12,7 @@ using options = clopts< // clang-format off
     option<"--connect", "The server IP to connect to">,
     option<"--name", "The name to set for us">,
     option<"--password", "The password to use for login">,
+    option<"--log-level", "Minimum level of messages to log: trace, debug, info, warning, or error">,
     help<>
 >; // clang-format on
 
@@ -24,8 +25,18 @@ static auto SetUpPath() -> Result<> {
 int main(int argc, char** argv) {
     auto opts = options::parse(argc, argv);
 
+    if (auto level = opts.get<"--log-level">()) {
+        auto parsed = ParseLogLevel(*level);
+        if (not parsed) {
+            std::println(stderr, "{}", parsed.error());
+            return 1;
+        }
+
+        SetLogLevel(parsed.value());
+    }
+
     if (auto res = SetUpPath(); not res)
-        Log("Failed to set up path: {}", res.error());
+        Log<LogLevel::Error>("Failed to set up path: {}", res.error());
 
     if (opts.get<"--connect">()) {
         if (not opts.get<"--name">() or not opts.get<"--password">()) {
@@ -27,21 +27,19 @@ DrawableTexture::DrawableTexture(
     GLenum target,
     GLenum unit,
     bool tile
-) : Texture(data, width, height, format, type, target, unit, tile) {
-    vao.add_buffer(create_vertices(Size{width, height}), GL_TRIANGLE_STRIP);
-}
+) : Texture(data, width, height, format, type, target, unit, tile) {}
 
 auto DrawableTexture::LoadFromFile(fs::PathRef path) -> DrawableTexture {
     auto file = File::Read(path);
     if (not file) {
-        Log("{}", file.error());
+        Log<LogLevel::Error, LogCategory::Render>("{}", file.error());
         return GetDefaultTexture();
     }
 
     int wd, ht;
     auto data = WebPDecodeRGBA(file.value().data<u8>(), file.value().size(), &wd, &ht);
     if (not data) {
-        Log("Could not decode image '{}'", path.string());
+        Log<LogLevel::Error, LogCategory::Render>("Could not decode image '{}'", path.string());
         return GetDefaultTexture();
     }
 
@@ -66,11 +64,6 @@ auto DrawableTexture::create_vertices_scaled(f32 scale) const -> std::array<vec4
     return MakeVerts(f32(width) * scale, f32(height) * scale, 1, 1);
 }
 
-void DrawableTexture::draw_vertices() const {
-    bind();
-    vao.draw_vertices();
-}
-
 struct Shader : Descriptor<glDeleteShader> {
     friend ShaderProgram;
     static auto Compile(GLenum type, std::span<const char> source) -> Result<Shader>;
@@ -99,11 +92,94 @@ auto Shader::Compile(GLenum type, std::span<const char> source) -> Result<Shader
     return std::move(shader);
 }
 
+auto GLState::Get() -> GLState& {
+    // Trivially destructible so that OpenGL objects with static
+    // storage duration can still use this when they’re destroyed.
+    static_assert(std::is_trivially_destructible_v<GLState>);
+    thread_local constinit GLState state;
+    return state;
+}
+
+void GLState::bind_texture(GLenum unit, GLenum target, GLuint texture) {
+    auto index = usz(+unit - +GL_TEXTURE0);
+    Assert(index < MaxTextureUnits, "Texture unit out of range");
+    if (active_unit != unit) {
+        active_unit = unit;
+        glActiveTexture(unit);
+    } else {
+        Skip();
+    }
+
+    // We only ever use 2D textures, so don’t bother tracking the target.
+    if (textures[index] != texture) {
+        textures[index] = texture;
+        glBindTexture(target, texture);
+    } else {
+        Skip();
+    }
+}
+
+void GLState::bind_vertex_arrays(GLuint vao) {
+    if (vertex_arrays == vao) return Skip();
+    vertex_arrays = vao;
+    glBindVertexArray(vao);
+}
+
+void GLState::forget_program(GLuint p) {
+    if (program == p) program = 0;
+}
+
+void GLState::forget_texture(GLuint texture) {
+    for (auto& t : textures)
+        if (t == texture) t = 0;
+}
+
+void GLState::forget_vertex_arrays(GLuint vao) {
+    if (vertex_arrays == vao) vertex_arrays = 0;
+}
+
+void GLState::set_blend(bool enabled) {
+    if (blend == enabled) return Skip();
+    blend = enabled;
+    if (enabled) glEnable(GL_BLEND);
+    else glDisable(GL_BLEND);
+}
+
+void GLState::use_program(GLuint p) {
+    if (program == p) return Skip();
+    program = p;
+    glUseProgram(p);
+}
+
+void ShaderProgram::BindUniformBlocks() {
+    auto frame = glGetUniformBlockIndex(descriptor, "Frame");
+    if (frame != GL_INVALID_INDEX) glUniformBlockBinding(descriptor, frame, FrameUniformBinding);
+}
+
+void ShaderProgram::CacheUniformLocations() {
+    GLint count{}, max_length{};
+    glGetProgramiv(descriptor, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(descriptor, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+    std::string buffer(usz(max_length), '\0');
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length{};
+        GLint size{};
+        GLenum type{};
+        glGetActiveUniform(descriptor, GLuint(i), max_length, &length, &size, &type, buffer.data());
+        std::string name{buffer.data(), usz(length)};
+        auto location = glGetUniformLocation(descriptor, name.c_str());
+        uniforms.emplace_back(std::move(name), location);
+    }
+}
+
 template <typename... T>
 void ShaderProgram::SetUniform(ZTermString name, auto callable, T... args) {
-    auto u = glGetUniformLocation(descriptor, name.c_str());
-    if (u == -1) return;
-    callable(u, args...);
+    // Uniforms that are optimised out are not in the list, which is
+    // fine since setting them would do nothing anyway.
+    auto it = rgs::find(uniforms, name.sv(), &std::pair<std::string, GLint>::first);
+    if (it == uniforms.end()) return;
+    callable(it->second, args...);
 }
 
 auto ShaderProgram::Compile(
@@ -128,6 +204,8 @@ auto ShaderProgram::Compile(
         return Error("Shader program linking failed: {}", info_log.get());
     }
 
+    program.BindUniformBlocks();
+    program.CacheUniformLocations();
     return std::move(program);
 }
 
@@ -194,11 +272,46 @@ auto Texture::MaxSize() -> GLint {
 }
 
 void Texture::bind() const {
-    glActiveTexture(unit);
-    glBindTexture(target, descriptor);
+    GLState::Get().bind_texture(unit, target, descriptor);
+}
+
+void Texture::resize(u32 new_width, u32 new_height) {
+    Assert(new_width >= width and new_height >= height, "Cannot shrink a texture");
+    if (new_width == width and new_height == height) return;
+
+    // We may be in the middle of rendering into a framebuffer, so
+    // restore whatever state we change here.
+    GLint previous_framebuffer;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous_framebuffer);
+    bool scissor = glIsEnabled(GL_SCISSOR_TEST) == GL_TRUE;
+    defer {
+        glBindFramebuffer(GL_FRAMEBUFFER, GLuint(previous_framebuffer));
+        if (scissor) glEnable(GL_SCISSOR_TEST);
+    };
+
+    // Keep tiling the texture if it was tiled before.
+    GLint wrap;
+    bind();
+    glGetTexParameteriv(target, GL_TEXTURE_WRAP_S, &wrap);
+
+    // The contents of a new texture are undefined, so clear it first.
+    Texture t{nullptr, new_width, new_height, format, type, target, unit, GLenum(wrap) == GL_REPEAT};
+    Framebuffer dest{t};
+    dest.bind();
+    glDisable(GL_SCISSOR_TEST);
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // Then, copy the old contents from a framebuffer that reads from us.
+    Framebuffer src{*this};
+    src.bind();
+    t.bind();
+    glCopyTexSubImage2D(target, 0, 0, 0, 0, 0, GLsizei(width), GLsizei(height));
+    *this = std::move(t);
 }
 
 void Texture::write(u32 x, u32 y, u32 width, u32 height, const void* data) {
+    bind();
     glTexSubImage2D(
         target,
         0,
@@ -212,6 +325,31 @@ void Texture::write(u32 x, u32 y, u32 width, u32 height, const void* data) {
     );
 }
 
+Framebuffer::Framebuffer(Texture& texture) : _size{texture.size} {
+    glGenFramebuffers(1, &descriptor);
+    bind();
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture.target, texture.descriptor, 0);
+    if (auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER); status != GL_FRAMEBUFFER_COMPLETE)
+        Log<LogLevel::Error, LogCategory::Render>("Framebuffer is incomplete: {}", +status);
+    BindDefault();
+}
+
+void Framebuffer::bind() const { glBindFramebuffer(GL_FRAMEBUFFER, descriptor); }
+void Framebuffer::BindDefault() { glBindFramebuffer(GL_FRAMEBUFFER, 0); }
+
+UniformBuffer::UniformBuffer(GLsizeiptr size, GLuint binding) : size{size} {
+    glGenBuffers(1, &descriptor);
+    glBindBuffer(GL_UNIFORM_BUFFER, descriptor);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, descriptor);
+}
+
+void UniformBuffer::Store(const void* data, GLsizeiptr bytes) {
+    Assert(bytes == size, "Uniform buffer size mismatch");
+    glBindBuffer(GL_UNIFORM_BUFFER, descriptor);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, bytes, data);
+}
+
 template <typename T>
 VertexBuffer::VertexBuffer(std::span<const T> data, GLenum draw_mode) : draw_mode{draw_mode} {
     glGenBuffers(1, &descriptor);
@@ -245,6 +383,20 @@ void VertexBuffer::copy_data(Vertices<2> data, GLenum usage) { CopyImpl(data, us
 void VertexBuffer::copy_data(Vertices<3> data, GLenum usage) { CopyImpl(data, usage); }
 void VertexBuffer::copy_data(Vertices<4> data, GLenum usage) { CopyImpl(data, usage); }
 
+template <typename T>
+void VertexBuffer::StreamImpl(std::span<const T> data) {
+    bind();
+    auto bytes = GLsizeiptr(data.size_bytes());
+    capacity = std::max(capacity, bytes);
+    glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, data.data());
+    size = GLsizei(data.size());
+}
+
+void VertexBuffer::stream(std::span<const BatchVertex> data) { StreamImpl(data); }
+void VertexBuffer::stream(std::span<const RectInstance> data) { StreamImpl(data); }
+void VertexBuffer::stream(std::span<const GlyphInstance> data) { StreamImpl(data); }
+
 void VertexBuffer::draw() const {
     bind();
     glDrawArrays(draw_mode, 0, size);
@@ -280,24 +432,65 @@ auto VertexArrays::add_buffer(GLenum draw_mode) -> VertexBuffer& {
     return add_buffer(Vertices<2>{}, draw_mode);
 }
 
-void VertexArrays::bind() const { glBindVertexArray(descriptor); }
+void VertexArrays::bind() const { GLState::Get().bind_vertex_arrays(descriptor); }
 
 void VertexArrays::draw_vertices() const {
     bind();
     for (const auto& vbo : buffers) vbo.draw();
 }
 
-void VertexArrays::unbind() const { glBindVertexArray(0); }
+void VertexArrays::rebase(usz first) {
+    Assert(buffers.size() == 1, "Can only rebase vertex arrays with a single buffer");
+    bind();
+    buffers.front().bind();
+    ApplyLayout(first);
+}
+
+void VertexArrays::unbind() const { GLState::Get().bind_vertex_arrays(0); }
+
+void VertexArrays::ApplyLayout(usz first) {
+    auto Attribute = [&](
+        GLuint index,
+        GLint components,
+        usz stride,
+        usz offset,
+        GLuint divisor = 0,
+        GLenum type = GL_FLOAT,
+        GLboolean normalised = GL_FALSE
+    ) {
+        glEnableVertexAttribArray(index);
+        glVertexAttribPointer(
+            index,
+            components,
+            type,
+            normalised,
+            GLsizei(stride),
+            reinterpret_cast<const void*>(first * stride + offset)
+        );
+        glVertexAttribDivisor(index, divisor);
+    };
 
-void VertexArrays::ApplyLayout() {
     switch (layout) {
         case VertexLayout::Position2D:
-            glEnableVertexAttribArray(0);
-            glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+            Attribute(0, 2, sizeof(vec2), 0);
             return;
         case VertexLayout::PositionTexture4D:
-            glEnableVertexAttribArray(0);
-            glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, nullptr);
+            Attribute(0, 4, sizeof(vec4), 0);
+            return;
+        case VertexLayout::Batch:
+            Attribute(0, 4, sizeof(BatchVertex), offsetof(BatchVertex, position));
+            Attribute(1, 4, sizeof(BatchVertex), offsetof(BatchVertex, colour));
+            Attribute(2, 4, sizeof(BatchVertex), offsetof(BatchVertex, params));
+            return;
+        case VertexLayout::RectInstance:
+            Attribute(0, 4, sizeof(RectInstance), offsetof(RectInstance, box), 1);
+            Attribute(1, 4, sizeof(RectInstance), offsetof(RectInstance, colour), 1);
+            Attribute(2, 4, sizeof(RectInstance), offsetof(RectInstance, params), 1);
+            return;
+        case VertexLayout::GlyphInstance:
+            Attribute(0, 4, sizeof(GlyphInstance), offsetof(GlyphInstance, box), 1);
+            Attribute(1, 4, sizeof(GlyphInstance), offsetof(GlyphInstance, atlas), 1, GL_UNSIGNED_SHORT);
+            Attribute(2, 4, sizeof(GlyphInstance), offsetof(GlyphInstance, colour), 1, GL_UNSIGNED_BYTE, GL_TRUE);
             return;
     }
 
@@ -18,6 +18,7 @@
 // Include order matters here!
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_MODULE_H
 #include <freetype/tttables.h>
 // clang-format on
 
@@ -29,12 +30,12 @@ using namespace base;
 #define check SDLCallImpl{}->*
 struct SDLCallImpl {
     void operator->*(bool cond) {
-        if (not cond) Log("SDL call failed: {}", SDL_GetError());
+        if (not cond) Log<LogLevel::Error, LogCategory::Render>("SDL call failed: {}", SDL_GetError());
     }
 
     template <typename T>
     auto operator->*(T* ptr) -> T* {
-        if (not ptr) Log("SDL call failed: {}", SDL_GetError());
+        if (not ptr) Log<LogLevel::Error, LogCategory::Render>("SDL call failed: {}", SDL_GetError());
         return ptr;
     }
 };
@@ -68,6 +69,26 @@ struct FontDimensions {
     u32 max_height;
 };
 
+// HarfBuzz uses integers for position values, so fonts are scaled
+// by this so we can get fractional values out of it.
+constexpr int HarfBuzzScale = 64;
+
+// Enable an OpenType feature.
+constexpr auto Feature(hb_tag_t tag) -> hb_feature_t {
+    return hb_feature_t{
+        .tag = tag,
+        .value = 1,
+        .start = HB_FEATURE_GLOBAL_START,
+        .end = HB_FEATURE_GLOBAL_END,
+    };
+}
+
+// OpenType feature list.
+constexpr hb_feature_t Features[]{
+    Feature(HB_TAG('l', 'i', 'g', 'a')),
+    Feature(HB_TAG('s', 's', '1', '3')),
+};
+
 // These MUST follow the order of the enumerators in 'TextStyle'.
 constexpr std::span<const char> Fonts[]{
     DefaultFontRegular,
@@ -84,6 +105,23 @@ constexpr Colour DefaultBGColour{45, 42, 46, 255};
 // =============================================================================
 //  Text and Fonts
 // =============================================================================
+// Load a face from one of our fonts and set it up for rendering
+// distance fields.
+void LoadFace(std::span<const char> font_file, FTLibraryHandle& library, FTFaceHandle& face) {
+    ftcall FT_Init_FreeType(&*library);
+
+    // Make sure the spread of the distance fields matches what we expect.
+    FT_Int spread = GlyphAtlas::Spread;
+    ftcall FT_Property_Set(*library, "sdf", "spread", &spread);
+    ftcall FT_New_Memory_Face(
+        *library,
+        reinterpret_cast<const FT_Byte*>(font_file.data()),
+        FT_Long(font_file.size()),
+        0,
+        &*face
+    );
+}
+
 auto DumpHBBuffer(hb_font_t* font, hb_buffer_t* buf) {
     std::string debug;
     debug.resize(10'000);
@@ -98,15 +136,308 @@ auto DumpHBBuffer(hb_font_t* font, hb_buffer_t* buf) {
         HB_BUFFER_SERIALIZE_FORMAT_TEXT,
         HB_BUFFER_SERIALIZE_FLAG_DEFAULT
     );
-    Log("Buffer: {}", debug);
+    Log<LogLevel::Debug, LogCategory::Render>("Buffer: {}", debug);
+}
+
+SkylinePacker::SkylinePacker(Size sz) : _size{sz} {
+    skyline.push_back({0, 0, sz.wd});
+}
+
+auto SkylinePacker::Fit(usz segment, Size sz) const -> std::optional<i32> {
+    // The rectangle rests on the highest segment below it.
+    auto x = skyline[segment].x;
+    if (x + sz.wd > size.wd) return std::nullopt;
+    i32 y = 0;
+    for (auto i = segment; i < skyline.size() and skyline[i].x < x + sz.wd; i++) {
+        y = std::max(y, skyline[i].y);
+        if (y + sz.ht > size.ht) return std::nullopt;
+    }
+
+    return y;
+}
+
+void SkylinePacker::grow(Size new_size) {
+    Assert(new_size.wd >= size.wd and new_size.ht >= size.ht, "Cannot shrink a packer");
+    if (new_size.wd > size.wd) skyline.push_back({size.wd, 0, new_size.wd - size.wd});
+    _size = new_size;
+}
+
+auto SkylinePacker::pack(Size sz) -> std::optional<xy> {
+    // Find the position where the top of the rectangle is lowest; prefer
+    // narrower segments on ties to keep the wider ones free for later.
+    std::optional<usz> best;
+    i32 best_y = 0, best_top = 0;
+    for (usz i = 0; i < skyline.size(); i++) {
+        auto y = Fit(i, sz);
+        if (not y) continue;
+        auto top = *y + sz.ht;
+        if (not best or top < best_top or (top == best_top and skyline[i].wd < skyline[*best].wd)) {
+            best = i;
+            best_y = *y;
+            best_top = top;
+        }
+    }
+
+    if (not best) return std::nullopt;
+
+    // Add a segment for the top of the rectangle, and cut away
+    // whatever part of the skyline is now below it.
+    xy pos{skyline[*best].x, best_y};
+    skyline.insert(skyline.begin() + isz(*best), {pos.x, best_top, sz.wd});
+    for (auto i = *best + 1; i < skyline.size();) {
+        auto end = skyline[i - 1].x + skyline[i - 1].wd;
+        auto& s = skyline[i];
+        if (s.x >= end) break;
+        if (s.x + s.wd <= end) {
+            skyline.erase(skyline.begin() + isz(i));
+            continue;
+        }
+
+        s.wd -= end - s.x;
+        s.x = end;
+        break;
+    }
+
+    // Merge adjacent segments of the same height.
+    for (usz i = 0; i + 1 < skyline.size();) {
+        if (skyline[i].y == skyline[i + 1].y) {
+            skyline[i].wd += skyline[i + 1].wd;
+            skyline.erase(skyline.begin() + isz(i + 1));
+        } else {
+            i++;
+        }
+    }
+
+    return pos;
+}
+
+auto GlyphAtlas::AllocGlyph(Size sz) -> std::optional<xy> {
+    // Leave a gap between glyphs so linear filtering doesn’t
+    // bleed neighbouring glyphs into each other.
+    Size padded{sz.wd + 1, sz.ht + 1};
+    for (;;) {
+        if (auto pos = packer.pack(padded)) return pos;
+        if (not GrowAtlas()) return std::nullopt;
+    }
+}
+
+auto GlyphAtlas::AddGlyph(Size sz, std::vector<std::byte> bitmap) -> std::optional<xy> {
+    auto pos = AllocGlyph(sz);
+    if (not pos) return std::nullopt;
+
+    // We may not be on the main thread, so leave the glyph for
+    // the main thread to upload later.
+    pending.emplace_back(*pos, sz, std::move(bitmap));
+    dirty.store(true, std::memory_order_release);
+    return pos;
+}
+
+auto GlyphAtlas::GrowAtlas() -> bool {
+    // Double whichever dimension is smaller.
+    auto old = packer.size;
+    auto sz = old;
+    if (old.wd < max_atlas_size and (old.wd <= old.ht or old.ht >= max_atlas_size))
+        sz.wd = std::min(old.wd * 2, max_atlas_size);
+    else if (old.ht < max_atlas_size)
+        sz.ht = std::min(old.ht * 2, max_atlas_size);
+    else return false;
+
+    // Glyphs stay where they are, so the texture only needs to be
+    // resized; we do that when we next upload glyphs.
+    packer.grow(sz);
+    return true;
+}
+
+GlyphAtlas::GlyphAtlas(FT_Face face, std::span<const char> font_file)
+    : face{face}, font_file{font_file} {
+    // Glyphs are always rasterised at the same size, so give the atlas
+    // a size object of its own rather than setting the size every time.
+    ftcall FT_New_Size(face, &reference_size);
+    ftcall FT_Activate_Size(reference_size);
+    ftcall FT_Set_Pixel_Sizes(face, 0, ReferenceSize);
+}
+
+void GlyphAtlas::add_glyphs(std::span<const FT_UInt> indices) {
+    std::vector<FT_UInt> missing;
+    for (auto i : indices)
+        if (not glyphs.contains(i))
+            missing.push_back(i);
+
+    rgs::sort(missing);
+    missing.erase(rgs::unique(missing).begin(), missing.end());
+
+    // Don’t bother with threads if there are only a few glyphs.
+    auto threads = std::min({
+        usz(std::max(std::thread::hardware_concurrency(), 1u)),
+        missing.size() / MinGlyphsPerThread,
+        MaxRasteriserThreads,
+    });
+
+    if (threads <= 1) {
+        for (auto i : missing) glyph(i);
+        return;
+    }
+
+    // Rasterise the glyphs in parallel, but pack them on this thread
+    // so the layout of the atlas doesn’t depend on timing.
+    std::vector<std::optional<Bitmap>> bitmaps(missing.size());
+    rasterisers.run(font_file, missing, bitmaps, threads);
+    for (auto [i, bitmap] : vws::zip(missing, bitmaps)) Insert(i, std::move(bitmap));
+}
+
+GlyphAtlas::RasteriserPool::~RasteriserPool() {
+    {
+        std::unique_lock _{mutex};
+        stop = true;
+    }
+
+    work_cv.notify_all();
+    for (auto& w : workers) w->thread.join();
+}
+
+void GlyphAtlas::RasteriserPool::run(
+    std::span<const char> font_file,
+    std::span<const FT_UInt> glyph_indices,
+    std::span<std::optional<Bitmap>> out,
+    usz threads
+) {
+    // Start any threads we don’t have yet. Only the caller ever changes
+    // the generation, so we can read it without holding the lock.
+    while (workers.size() < threads) {
+        auto& w = *workers.emplace_back(std::make_unique<Worker>());
+        LoadFace(font_file, w.library, w.face);
+        ftcall FT_Set_Pixel_Sizes(*w.face, 0, ReferenceSize);
+        w.thread = std::jthread{[this, &w, index = workers.size() - 1, seen = generation] {
+            Work(w, index, seen);
+        }};
+    }
+
+    // Hand out the batch and wait for everyone to finish it.
+    std::unique_lock lock{mutex};
+    indices = glyph_indices;
+    bitmaps = out;
+    active = remaining = threads;
+    generation++;
+    work_cv.notify_all();
+    done_cv.wait(lock, [&] { return remaining == 0; });
+}
+
+void GlyphAtlas::RasteriserPool::Work(Worker& w, usz index, u64 seen) {
+    for (;;) {
+        std::span<const FT_UInt> in;
+        std::span<std::optional<Bitmap>> out;
+        usz stride;
+        {
+            std::unique_lock lock{mutex};
+            work_cv.wait(lock, [&] { return stop or generation != seen; });
+            if (stop) return;
+            seen = generation;
+            if (index >= active) continue;
+            in = indices;
+            out = bitmaps;
+            stride = active;
+        }
+
+        for (usz i = index; i < in.size(); i += stride) out[i] = Rasterise(*w.face, in[i]);
+        std::unique_lock _{mutex};
+        if (--remaining == 0) done_cv.notify_one();
+    }
+}
+
+auto GlyphAtlas::glyph(FT_UInt index) -> const Metrics& {
+    if (auto it = glyphs.find(index); it != glyphs.end()) return it->second;
+    ftcall FT_Activate_Size(reference_size);
+    return Insert(index, Rasterise(face, index));
+}
+
+auto GlyphAtlas::Insert(FT_UInt index, std::optional<Bitmap> bitmap) -> const Metrics& {
+    auto& g = glyphs[index];
+    if (not bitmap) {
+        Log<LogLevel::Warning, LogCategory::Render>("Failed to load glyph #{}", index);
+        return g;
+    }
+
+    // Empty glyphs, e.g. spaces, don’t need any space in the atlas.
+    auto sz = bitmap->size;
+    if (sz.wd == 0 or sz.ht == 0) return g;
+
+    // If the atlas is full, drop the glyph rather than crashing.
+    auto pos = AddGlyph(sz, std::move(bitmap->data));
+    if (not pos) {
+        Log<LogLevel::Error, LogCategory::Render>("Font atlas is full; dropping glyph #{}", index);
+        return g;
+    }
+
+    // The distance field extends past the glyph on all sides.
+    g = {
+        .atlas_pos = *pos,
+        .size = {sz.wd - 2 * Spread, sz.ht - 2 * Spread},
+        .bearing = bitmap->bearing + vec2(Spread, -Spread),
+    };
+
+    return g;
+}
+
+auto GlyphAtlas::Rasterise(FT_Face face, FT_UInt index) -> std::optional<Bitmap> {
+    // Rasterise the glyph at the reference size. Hinting is meant for
+    // a specific pixel size, so don’t bother with it.
+    if (
+        FT_Load_Glyph(face, index, FT_LOAD_NO_HINTING) != 0 or
+        FT_Render_Glyph(face->glyph, FT_RENDER_MODE_SDF) != 0
+    ) return std::nullopt;
+
+    // Copy the bitmap since it is overwritten by the next glyph.
+    auto& bitmap = face->glyph->bitmap;
+    auto data = reinterpret_cast<const std::byte*>(bitmap.buffer);
+    Size sz{bitmap.width, bitmap.rows};
+    return Bitmap{
+        .size = sz,
+        .bearing = {face->glyph->bitmap_left, face->glyph->bitmap_top},
+        .data = std::vector(data, data + usz(sz.area())),
+    };
+}
+
+auto GlyphAtlas::texture() -> const Texture& {
+    if (not dirty.load(std::memory_order_acquire)) return atlas;
+
+    // Don’t hold the lock while we talk to the GPU.
+    std::vector<PendingGlyph> glyphs_to_upload;
+    Size sz;
+    {
+        std::unique_lock _{mutex};
+        dirty.store(false, std::memory_order_relaxed);
+        std::swap(glyphs_to_upload, pending);
+        sz = packer.size;
+    }
+
+    // Create the texture when we upload the first glyph; after that,
+    // it only needs to grow along with the packer.
+    if (atlas.width == 0) {
+        std::vector<std::byte> zeroes(usz(sz.area()));
+        atlas = Texture(zeroes.data(), u32(sz.wd), u32(sz.ht), GL_RED, GL_UNSIGNED_BYTE);
+    } else if (atlas.size != sz) {
+        atlas.resize(u32(sz.wd), u32(sz.ht));
+    }
+
+    // Upload only the glyphs themselves.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (auto& g : glyphs_to_upload) {
+        atlas.write(
+            u32(g.pos.x),
+            u32(g.pos.y),
+            u32(g.size.wd),
+            u32(g.size.ht),
+            g.bitmap.data()
+        );
+    }
+
+    return atlas;
 }
 
 Font::Font(FT_Face ft_face, FontSize size, TextStyle style)
     : face{ft_face},
       _size{size},
       _style{style} {
-    // Set the font size.
-    FT_Set_Pixel_Sizes(ft_face, 0, +size);
     f32 em = f32(ft_face->units_per_EM);
 
     // Compute the interline skip.
@@ -115,24 +446,34 @@ Font::Font(FT_Face ft_face, FontSize size, TextStyle style)
     skip = u32(1.2f * +size);
     // skip = u32(ft_face->height / f32(ft_face->units_per_EM) * size);
 
-    // Determine the maximum width and height amongst all glyphs; we
-    // need to do this now to ensure that the dimensions of a cell
-    // don’t change when we add glyphs; otherwise, we’d be invalidating
-    // the uv coordinates of already shaped text.
-    //
-    // Note: we use the advance width for x and the bounding box for y
-    // because that seems to more closely match the data we got from
-    // iterating over every glyph in the font and computing the maximum
-    // metrics.
-    atlas_entry_width = u32(std::ceil(ft_face->max_advance_width / em * +size));
-    atlas_entry_height = u32(std::ceil(+size * (ft_face->bbox.yMax - ft_face->bbox.yMin) / em));
-
     // Create a HarfBuzz font for it.
     auto f = hb_ft_font_create(ft_face, nullptr);
     Assert(f, "Failed to create HarfBuzz font");
     hb_font = f;
     hb_ft_font_set_funcs(hb_font.get());
 
+    // Note that HarfBuzz has its own copy of the face now, so we don’t
+    // need to set the size of ours; just scale the HarfBuzz font. This
+    // never changes, so it only needs to compute its metrics once.
+    hb_font_set_scale(f, +size * HarfBuzzScale, +size * HarfBuzzScale);
+
+    // All text uses the same properties and features, so we can
+    // reuse the same shape plan for everything.
+    hb_language = hb_language_from_string("en", -1);
+    hb_segment_properties_t props{
+        .direction = HB_DIRECTION_LTR,
+        .script = HB_SCRIPT_COMMON,
+        .language = hb_language,
+    };
+
+    hb_plan = hb_shape_plan_create_cached(
+        hb_font_get_face(f),
+        &props,
+        Features,
+        u32(std::size(Features)),
+        nullptr
+    );
+
     // According to the OpenType standard, the typographic ascender
     // and descender should be retrieved from the OS/2 table; other
     // 'ascender' and 'descender' fields may contain garbage.
@@ -146,10 +487,6 @@ Font::Font(FT_Face ft_face, FontSize size, TextStyle style)
     }
 }
 
-auto Font::atlas_height() const -> i32 {
-    return i32(atlas_rows * atlas_entry_height);
-}
-
 auto Font::bold() -> Font& {
     if (style & TextStyle::Bold) return *this;
     return renderer.font(size, style | TextStyle::Bold);
@@ -159,7 +496,6 @@ auto Font::italic() -> Font& {
     if (style & TextStyle::Italic) return *this;
     return renderer.font(size, style | TextStyle::Italic);
 }
-void Font::use() const { atlas.bind(); }
 
 auto Font::strut() const -> i32 { return i32(strut_asc + strut_desc); }
 auto Font::strut_split() const -> std::pair<i32, i32> { return {strut_asc, strut_desc}; }
@@ -184,13 +520,56 @@ Text::Text(Font& font, std::u32string content, TextAlign align)
 Text::Text(Font& font, std::string_view content, TextAlign align)
     : _align{align}, _content{text::ToUTF32(content)}, _font{&font} {}
 
-void Text::draw_vertices() const { reshape().vertices->draw_vertices(); }
+auto Text::drawable() const -> const ShapedText* {
+    if (shaped or PollJob()) return shaped.get();
+    if (job) return previous.get();
+    return reshape().shaped.get();
+}
+
+auto Text::get_pending() const -> bool {
+    return job and not job->result;
+}
+
+void Text::Invalidate() {
+    if (shaped) previous = std::move(shaped);
+    job = nullptr;
+}
+
+auto Text::PollJob() const -> bool {
+    if (not job or not job->result) return false;
+    shaped = job->result;
+    job = nullptr;
+    previous = nullptr;
+    return true;
+}
 
 auto Text::reshape() const -> const Text& {
-    if (not vertices.has_value()) font.shape(*this, nullptr);
+    if (shaped or PollJob()) return *this;
+
+    // We need the text now, so don’t wait for the job.
+    shaped = font.renderer.text_cache.shape(*this, nullptr);
+    job = nullptr;
+    previous = nullptr;
     return *this;
 }
 
+auto Text::shape_in_background() const -> bool {
+    if (shaped or PollJob()) return true;
+    if (job) return false;
+
+    // Someone else may have shaped the same text already.
+    auto& r = font.renderer;
+    auto key = TextCache::MakeKey(*this);
+    if (auto cached = r.text_cache.find(key)) {
+        shaped = std::move(cached);
+        previous = nullptr;
+        return true;
+    }
+
+    job = r.text_shaper->submit(std::move(key));
+    return false;
+}
+
 void Text::set_content(std::string_view new_text) {
     content = text::ToUTF32(new_text);
 }
@@ -198,37 +577,45 @@ void Text::set_content(std::string_view new_text) {
 void Text::set_desired_width(i32 desired) {
     if (desired == _desired_width) return;
     _desired_width = desired;
-    if (not vertices or desired < width or multiline) font.shape(*this, nullptr);
+
+    // A pending job may be for the old width; resubmitting it is
+    // cheap if it wasn’t, since jobs are shared.
+    if (shaped and (desired < width or multiline)) Invalidate();
+    else if (not shaped) job = nullptr;
 }
 
 void Text::set_align(TextAlign new_value) {
     if (_align == new_value) return;
     _align = new_value;
-    vertices = std::nullopt;
+    Invalidate();
 }
 
 void Text::set_content(std::u32string new_value) {
     if (new_value == _content) return;
     _content = std::move(new_value);
-    vertices = std::nullopt;
+    Invalidate();
 }
 
 void Text::set_font_size(FontSize new_size) {
     if (_font->size == new_size) return;
     _font = &Renderer::current().font(new_size, _font->style);
-    vertices = std::nullopt;
+    Invalidate();
 }
 
 void Text::set_reflow(Reflow new_value) {
     if (_reflow == new_value) return;
     _reflow = new_value;
-    if (desired_width != 0) vertices = std::nullopt;
+    if (desired_width != 0) Invalidate();
 }
 
 void Text::set_style(TextStyle new_value) {
     if (_font->style == new_value) return;
     _font = &Renderer::current().font(_font->size, new_value);
-    vertices = std::nullopt;
+    Invalidate();
+
+    // Each style has its own atlas, so the old glyphs can’t be drawn
+    // with the new font.
+    previous = nullptr;
 }
 
 // =============================================================================
@@ -249,26 +636,22 @@ void Text::set_style(TextStyle new_value) {
 //      each of which may either have to be reshaped or can reference existing
 //      shaping information from step 2.
 //
-//   4. Determine if we need to add any glyphs to the font atlas and do so.
-//
-//   5. Convert the shaped physical lines into vertices and upload the vertex data.
-void Font::shape(const Text& text, std::vector<TextCluster>* clusters) {
-    // Reset text properties in case we end up returning early.
-    text.vertices = VertexArrays{VertexLayout::PositionTexture4D};
-    text._width = text._height = text._depth = 0;
-    text._lines = 0;
-    if (text.empty) return;
+//   4. Position the glyphs of the shaped physical lines, adding any glyphs
+//      we need to the glyph atlas along the way.
+auto Font::shape(const TextKey& text, std::vector<TextCluster>* clusters) -> std::shared_ptr<const ShapedText> {
+    auto shaped = std::make_shared<ShapedText>();
+    if (text.content.empty()) return shaped;
 
     // Check that this font has been fully initialised.
     auto font = hb_font.get();
     Assert(font, "Forgot to call finalise()!");
 
+    // All sizes of a style share the same face and atlas.
+    std::unique_lock _{glyph_atlas->mutex};
+
     // Free buffers after we’re done.
     defer { hb_buffers_in_use = 0; };
 
-    // Set the font size.
-    FT_Set_Pixel_Sizes(face, 0, +size);
-
     // Refuse to go below a certain width to save us from major headaches.
     static constexpr i32 MinTextWidth = 40;
     const bool should_reflow = text.reflow != Reflow::None and text.desired_width != 0;
@@ -310,7 +693,7 @@ void Font::shape(const Text& text, std::vector<TextCluster>* clusters) {
     // Shape a single line; we need to do line breaks manually, so
     // we might have to call this multiple times.
     std::vector<Line> lines;
-    static constexpr int Scale = 64;
+    static constexpr int Scale = HarfBuzzScale;
     auto ShapeLine = [&](std::u32string_view line, hb_buffer_t* buf) mutable -> f32 {
         // Add the text and compute properties.
         hb_buffer_clear_contents(buf);
@@ -318,31 +701,11 @@ void Font::shape(const Text& text, std::vector<TextCluster>* clusters) {
         hb_buffer_add_utf32(buf, reinterpret_cast<const u32*>(line.data()), int(line.size()), 0, int(line.size()));
         hb_buffer_set_direction(buf, HB_DIRECTION_LTR);
         hb_buffer_set_script(buf, HB_SCRIPT_COMMON);
-        hb_buffer_set_language(buf, hb_language_from_string("en", -1));
+        hb_buffer_set_language(buf, hb_language);
         // hb_buffer_guess_segment_properties(buf);
 
-        // Scale the font; HarfBuzz uses integers for position values,
-        // so this is used so we can get fractional values out of it.
-        hb_font_set_scale(font, +size * Scale, +size * Scale);
-
-        // Enable an OpenType feature.
-        auto Feature = [](auto tag) {
-            return hb_feature_t{
-                .tag = tag,
-                .value = 1,
-                .start = HB_FEATURE_GLOBAL_START,
-                .end = HB_FEATURE_GLOBAL_END,
-            };
-        };
-
-        // OpenType feature list.
-        std::array features{
-            Feature(HB_TAG('l', 'i', 'g', 'a')),
-            Feature(HB_TAG('s', 's', '1', '3')),
-        };
-
         // Shape the text.
-        hb_shape(font, buf, features.data(), features.size());
+        hb_shape_plan_execute(hb_plan.get(), font, buf, Features, u32(std::size(Features)));
 
         // Compute the width of this line.
         f32 x = 0;
@@ -465,152 +828,56 @@ void Font::shape(const Text& text, std::vector<TextCluster>* clusters) {
         return rgs::max_element(lines, {}, &Line::width)->width;
     };
 
-    // Rebuild the font atlas, adding any new glyphs we need.
-    //
-    // We do this this way since precomputing the atlas for the
-    // entire font is rather expensive in terms of memory usage
-    // (over 100MB for a 96pt font), and time (it takes about 5
-    // second to build the atlas...).
-    auto RebuildAtlas = [&] {
-        // Collect all glyphs that are not part of the atlas.
-        for (auto& l : lines) {
-            auto [infos, _] = GetInfo(l.buf, l.start, l.end);
-            for (auto& i : infos) {
-                // If the glyph is already in the atlas, we don’t need to do anything here.
-                auto g = i.codepoint;
-                if (auto it = glyphs.find(i.codepoint); it != glyphs.end()) continue;
-
-                // Load the glyph’s metrics.
-                glyphs_ordered.push_back(g);
-                if (FT_Load_Glyph(face, g, FT_LOAD_BITMAP_METRICS_ONLY) != 0) {
-                    Log("Failed to load glyph #{}", g);
-                    glyphs[g] = {};
-                    continue;
-                }
-
-                glyphs[g] = {
-                    .atlas_index = u32(glyphs_ordered.size() - 1),
-                    .size = {face->glyph->bitmap.width, face->glyph->bitmap.rows},
-                    .bearing = {face->glyph->bitmap_left, face->glyph->bitmap_top},
-                };
-            }
-        }
-
-        // At this point, we know what glyphs we need.
-        if (atlas_entries == glyphs_ordered.size()) return;
-        defer { atlas_entries = u32(glyphs_ordered.size()); };
-
-        // Determine how many characters we can fit in a single row since an
-        // entire font tends to exceed OpenGL’s texture size limits in terms
-        // of width.
-        auto max_columns = Texture::MaxSize() / atlas_entry_width;
-        atlas_rows = u32(std::ceil(f64(glyphs_ordered.size()) / max_columns));
-        auto texture_height = atlas_height();
-        auto atlas_columns = atlas_width / atlas_entry_width;
-
-        // Allocate memory for the texture.
-        atlas_buffer.resize(usz(atlas_width * texture_height));
-
-        // Add new glyphs to the atlas.
-        //
-        // Old glyphs don’t need to be updated since they don’t move because we
-        // keep the atlas *width* constant.
-        for (auto [i, glyph_index] : glyphs_ordered | vws::drop(atlas_entries) | vws::enumerate) {
-            // This *should* never fail because we're loading glyphs and
-            // not codepoints, but prefer not to crash if it does fail.
-            if (FT_Load_Glyph(face, glyph_index, FT_LOAD_RENDER) != 0) {
-                Log("Failed to load glyph #{}", glyph_index);
-                continue;
-            }
-
-            // Index should start at the first new entry.
-            i += atlas_entries;
-            u32 row = u32(i) / atlas_columns;
-            u32 col = u32(i) % atlas_columns;
-
-            // Copy the glyph’s bitmap data into the atlas.
-            // TODO: Optimisation: If the bitmap is empty (i.e. every cell is 0), then
-            //       we should not create any vertices for this glyph below.
-            for (usz r = 0; r < face->glyph->bitmap.rows; r++) {
-                std::memcpy(
-                    atlas_buffer.data() + (row * atlas_entry_height + r) * u32(atlas_width) + col * atlas_entry_width,
-                    face->glyph->bitmap.buffer + r * face->glyph->bitmap.width,
-                    face->glyph->bitmap.width
-                );
-            }
-        }
-
-        // Rebuild the texture.
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        atlas = Texture(
-            atlas_buffer.data(),
-            atlas_width,
-            texture_height,
-            GL_RED,
-            GL_UNSIGNED_BYTE
-        );
-    };
-
-    // Add the vertices for a line to the vertex buffer.
-    std::vector<vec4> verts;
-    auto atlas_columns = atlas_width / atlas_entry_width;
-    auto AddVertices = [&](const Line& l, f32 xbase, f32 ybase) -> std::pair<f32, f32> {
+    // Add the glyphs of a line to the shaped text.
+    f32 scale = f32(+size) / f32(GlyphAtlas::ReferenceSize);
+    shaped->scale = scale;
+    auto AddGlyphs = [&](const Line& l, f32 xbase, f32 ybase) -> std::pair<f32, f32> {
         auto [infos, positions] = GetInfo(l.buf, l.start, l.end);
         f32 x = xbase;
         f32 line_ht = 0, line_dp = 0;
 
-        // Compute the vertices for each glyph.
+        // Compute the position of each glyph.
         if (clusters) clusters->clear();
         for (auto [info, pos] : vws::zip(infos, positions)) {
             if (clusters) clusters->emplace_back(info.cluster, i32(x));
 
             // Note: 'codepoint' here is actually a glyph index in the
             // font after shaping, and not a codepoint.
-            auto& g = glyphs.at(u32(info.codepoint));
+            auto& g = glyph_atlas->glyph(u32(info.codepoint));
             f32 xoffs = pos.x_offset / f32(Scale);
             f32 xadv = pos.x_advance / f32(Scale);
             f32 yoffs = pos.y_offset / f32(Scale);
 
             // Compute the x and y position using the glyph’s metrics and
-            // the shaping data provided by HarfBuzz.
-            f32 desc = g.size.y - g.bearing.y;
-            f32 xpos = x + g.bearing.x + xoffs;
+            // the shaping data provided by HarfBuzz; the metrics are for
+            // the atlas’s reference size, so scale them to our size.
+            f32 desc = (g.size.y - g.bearing.y) * scale;
+            f32 xpos = x + g.bearing.x * scale + xoffs;
             f32 ypos = ybase + yoffs - desc;
-            f32 w = g.size.x;
-            f32 h = g.size.y;
-
-            // Compute the offset of the glyph in the atlas.
-            f64 tx = f64(g.atlas_index % atlas_columns) * atlas_entry_width;
-            f64 ty = f64(g.atlas_index / atlas_columns) * atlas_entry_height;
-
-            // Compute the uv coordinates of the glyph; note that the glyph
-            // is likely smaller than the width of an atlas cell, so perform
-            // this calculation in pixels.
-            //
-            // The atlas width is constant, so we can factor it into the U
-            // coordinate’s calculation here and now. On the other hand, the
-            // V coordinate may have to change since the atlas *height* may
-            // change; we deal with this by computing the actual V coordinate
-            // in the vertex shader by passing the current atlas height as
-            // a uniform, for which reason we encode absolute V coordinates
-            // here.
-            f32 u0 = f32(f64(tx) / atlas_width);
-            f32 u1 = f32(f64(tx + w) / atlas_width);
-            f32 v0 = f32(ty);
-            f32 v1 = f32(ty + h);
+            f32 h = g.size.y * scale;
 
             // Advance past the glyph.
             x += xadv;
             line_ht = std::max(line_ht, yoffs - desc + h);
             line_dp = std::max(line_dp, desc);
 
-            // Build vertices for the glyph’s position and texture coordinates.
-            verts.push_back({xpos, ypos + h, u0, v0});
-            verts.push_back({xpos, ypos, u0, v1});
-            verts.push_back({xpos + w, ypos, u1, v1});
-            verts.push_back({xpos, ypos + h, u0, v0});
-            verts.push_back({xpos + w, ypos, u1, v1});
-            verts.push_back({xpos + w, ypos + h, u1, v0});
+            // Empty glyphs don’t need to be drawn.
+            if (g.size.x <= 0 or g.size.y <= 0) continue;
+
+            // The quad includes the spread of the distance field so the
+            // shader can antialias the edges of the glyph; the atlas
+            // rectangle already includes it, and the size of the quad
+            // is that of the rectangle, scaled to our size.
+            f32 spread = GlyphAtlas::Spread * scale;
+            shaped->glyphs.push_back({
+                .pos = {xpos - spread, ypos - spread},
+                .atlas = {
+                    u16(g.atlas_pos.x),
+                    u16(g.atlas_pos.y),
+                    u16(g.size.x + 2 * GlyphAtlas::Spread),
+                    u16(g.size.y + 2 * GlyphAtlas::Spread),
+                },
+            });
         }
 
         return {line_ht, line_dp};
@@ -618,12 +885,21 @@ void Font::shape(const Text& text, std::vector<TextCluster>* clusters) {
 
     // Shape (and if need be reflow) the lines.
     auto lines_to_shape = u32stream{text.content}.lines() | vws::transform(&u32stream::text) | rgs::to<std::vector>();
-    if (lines_to_shape.empty()) return;
+    if (lines_to_shape.empty()) return shaped;
     f32 max_x = ShapeLines(lines_to_shape);
-    text._lines = i32(lines.size());
+    shaped->lines = i32(lines.size());
+
+    // Add any glyphs we don’t have yet all at once, so that the atlas
+    // can rasterise them in parallel if there are many of them, e.g.
+    // the first time we show a large block of text.
+    std::vector<FT_UInt> missing;
+    for (const auto& line : lines) {
+        for (auto& info : GetInfo(line.buf, line.start, line.end).first)
+            if (not glyph_atlas->glyphs.contains(info.codepoint))
+                missing.push_back(info.codepoint);
+    }
 
-    // Rebuild the texture atlas.
-    RebuildAtlas();
+    if (not missing.empty()) glyph_atlas->add_glyphs(missing);
 
     // Finally, add vertices for each line.
     f32 ybase = 0;
@@ -640,8 +916,8 @@ void Font::shape(const Text& text, std::vector<TextCluster>* clusters) {
             Unreachable();
         }();
 
-        // Build the vertices for this line.
-        auto [line_ht, line_dp] = AddVertices(line, xbase, ybase);
+        // Add the glyphs of this line.
+        auto [line_ht, line_dp] = AddGlyphs(line, xbase, ybase);
 
         // Update the total height and width.
         if (ybase == 0) {
@@ -657,11 +933,135 @@ void Font::shape(const Text& text, std::vector<TextCluster>* clusters) {
         ybase -= skip_amount;
     }
 
-    // And upload the vertices.
-    text.vertices->add_buffer().copy_data(verts);
-    text._width = max_x;
-    text._height = ht;
-    text._depth = dp;
+    shaped->width = max_x;
+    shaped->height = ht;
+    shaped->depth = dp;
+    return shaped;
+}
+
+// =============================================================================
+//  Text Cache
+// =============================================================================
+auto TextKey::Hash::operator()(const TextKey& k) const noexcept -> usz {
+    auto h = std::hash<std::u32string>{}(k.content);
+    h ^= std::hash<const Font*>{}(k.font) + 0x9e37'79b9'7f4a'7c15 + (h << 6) + (h >> 2);
+    h ^= std::hash<u64>{}(u64(+k.align) << 40 | u64(+k.reflow) << 32 | u32(k.desired_width)) + 0x9e37'79b9'7f4a'7c15 + (h << 6) + (h >> 2);
+    return h;
+}
+
+auto TextCache::MakeKey(const Text& text) -> TextKey {
+    // The desired width only matters if we’re reflowing.
+    bool reflow = text.reflow != Reflow::None and text.desired_width != 0;
+    return TextKey{
+        .content = text.content,
+        .font = &text.font,
+        .align = text.align,
+        .reflow = reflow ? text.reflow : Reflow::None,
+        .desired_width = reflow ? text.desired_width : 0,
+    };
+}
+
+auto TextCache::find(const TextKey& key) -> std::shared_ptr<const ShapedText> {
+    auto it = index.find(key);
+    if (it == index.end()) return nullptr;
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->second;
+}
+
+void TextCache::insert(TextKey key, std::shared_ptr<const ShapedText> shaped) {
+    if (auto it = index.find(key); it != index.end()) {
+        entries.splice(entries.begin(), entries, it->second);
+        it->second->second = std::move(shaped);
+        return;
+    }
+
+    // Evict the least recently used entry if we’re full; the entry may
+    // still be in use by a text object, which keeps it alive.
+    if (entries.size() == MaxEntries) {
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+
+    entries.emplace_front(key, std::move(shaped));
+    index.emplace(std::move(key), entries.begin());
+}
+
+auto TextCache::shape(const Text& text, std::vector<TextCluster>* clusters) -> std::shared_ptr<const ShapedText> {
+    // Reuse the cached result unless we need the clusters; either
+    // way, this is now the most recently used entry.
+    auto key = MakeKey(text);
+    if (not clusters) {
+        if (auto cached = find(key)) return cached;
+    }
+
+    auto shaped = text.font.shape(key, clusters);
+    insert(std::move(key), shaped);
+    return shaped;
+}
+
+// =============================================================================
+//  Background Shaping
+// =============================================================================
+TextShaper::TextShaper() {
+    worker = std::jthread{[this] { Run(); }};
+}
+
+TextShaper::~TextShaper() {
+    {
+        std::unique_lock _{mutex};
+        stop = true;
+    }
+
+    cv.notify_one();
+    if (worker.joinable()) worker.join();
+}
+
+auto TextShaper::poll(TextCache& cache) -> bool {
+    decltype(finished) done;
+    {
+        std::unique_lock _{mutex};
+        std::swap(done, finished);
+    }
+
+    for (auto& [job, shaped] : done) {
+        job->result = shaped;
+        cache.insert(job->key, std::move(shaped));
+        in_flight.erase(job->key);
+    }
+
+    return not done.empty();
+}
+
+void TextShaper::Run() {
+    for (;;) {
+        std::shared_ptr<ShapingJob> job;
+        {
+            std::unique_lock lock{mutex};
+            cv.wait(lock, [&] { return stop or not queued.empty(); });
+            if (stop) return;
+            job = std::move(queued.front());
+            queued.pop_front();
+        }
+
+        // The key is never modified after the job is submitted, so we
+        // can read it without holding the lock.
+        auto shaped = job->key.font->shape(job->key, nullptr);
+        std::unique_lock _{mutex};
+        finished.emplace_back(std::move(job), std::move(shaped));
+    }
+}
+
+auto TextShaper::submit(TextKey key) -> std::shared_ptr<ShapingJob> {
+    auto& job = in_flight[key];
+    if (job) return job;
+    job = std::make_shared<ShapingJob>(std::move(key));
+    {
+        std::unique_lock _{mutex};
+        queued.push_back(job);
+    }
+
+    cv.notify_one();
+    return job;
 }
 
 // =============================================================================
@@ -717,14 +1117,15 @@ Renderer::Renderer(int initial_wd, int initial_ht, bool set_active) {
     glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
 
     // Now that we have the sample count, create the actual window and context.
-    Log("Using {}x multisampling", max_samples);
+    Log<LogLevel::Info, LogCategory::Render>("Using {}x multisampling", max_samples);
     check SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, max_samples);
     CreateWindowAndContext(false);
 
     // After every gl function call (except 'glGetError'), log
-    // if there was an error.
+    // if there was an error. We also count calls here.
     setCallbackMaskExcept(glbinding::CallbackMask::After | glbinding::CallbackMask::Parameters, {"glGetError"});
     glbinding::setAfterCallback([](const glbinding::FunctionCall& call) {
+        GLState::Get().counters.calls++;
         auto err = glGetError();
         if (err != GL_NO_ERROR) {
             auto msg = [&] {
@@ -745,7 +1146,7 @@ Renderer::Renderer(int initial_wd, int initial_ht, bool set_active) {
                 ss << p.get();
             }
 
-            Log(
+            Log<LogLevel::Error, LogCategory::Render>(
                 "OpenGL error {} in {}({}): {}",
                 +err,
                 call.function->name(),
@@ -758,14 +1159,21 @@ Renderer::Renderer(int initial_wd, int initial_ht, bool set_active) {
     // Enable VSync.
     check SDL_GL_SetSwapInterval(1);
 
-    // Load shaders.
+    // Load shaders and create the buffer for the uniforms they share.
     reload_shaders();
+    frame_uniforms.emplace(GLsizeiptr(sizeof(FrameUniforms)), FrameUniformBinding);
+    text_shaper = std::make_unique<TextShaper>();
 
     // Enable blending, smooth lines, and multisampling.
-    glEnable(GL_BLEND);
+    GLState::Get().set_blend(true);
     glEnable(GL_LINE_SMOOTH);
     glEnable(GL_MULTISAMPLE);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // The alpha channel doesn’t matter for the window, but blending alpha
+    // like this means that anything we render into an initially transparent
+    // texture ends up with premultiplied alpha, which we can then blend
+    // correctly when we draw the texture.
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
     // Make this the current renderer.
     if (set_active) SetThreadRenderer(*this);
@@ -792,20 +1200,207 @@ void Renderer::SetThreadRenderer(Renderer& r) {
 Renderer::Frame::Frame(Renderer& r) : r(r) { r.frame_start(); }
 Renderer::Frame::~Frame() { r.frame_end(); }
 
+// =============================================================================
+//  Batching
+// =============================================================================
+auto Batcher::Bounds::overlaps(const Bounds& other) const -> bool {
+    return min.x <= other.max.x and other.min.x <= max.x and
+           min.y <= other.max.y and other.min.y <= max.y;
+}
+
+void Batcher::Bounds::merge(const Bounds& other) {
+    min = glm::min(min, other.min);
+    max = glm::max(max, other.max);
+}
+
+auto Batcher::add(const Key& key, const Bounds& bounds) -> std::vector<BatchVertex>& {
+    return Find(key, bounds).vertices;
+}
+
+auto Batcher::add_rect(ShaderProgram& shader, const Bounds& bounds) -> std::vector<RectInstance>& {
+    return Find({&shader, nullptr, GL_TRIANGLE_STRIP, Kind::Rects}, bounds).rects;
+}
+
+auto Batcher::add_glyphs(ShaderProgram& shader, const Texture& atlas, const Bounds& bounds) -> std::vector<GlyphInstance>& {
+    return Find({&shader, &atlas, GL_TRIANGLE_STRIP, Kind::Glyphs}, bounds).glyphs;
+}
+
+auto Batcher::Find(const Key& key, const Bounds& bounds) -> Batch& {
+    // Merge this into an earlier batch if nothing that is drawn
+    // after that batch overlaps the new draw.
+    for (usz i = used; i > 0 and used - i < Lookback; i--) {
+        auto& b = batches[i - 1];
+        if (b.key == key) {
+            b.bounds.merge(bounds);
+            return b;
+        }
+
+        if (b.bounds.overlaps(bounds)) break;
+    }
+
+    if (used == batches.size()) batches.emplace_back();
+    auto& b = batches[used++];
+    b.key = key;
+    b.bounds = bounds;
+    b.vertices.clear();
+    b.rects.clear();
+    b.glyphs.clear();
+    return b;
+}
+
+void Batcher::flush() {
+    if (used == 0) return;
+    defer { used = 0; };
+
+    // Upload everything at once.
+    staging.clear();
+    rect_staging.clear();
+    glyph_staging.clear();
+    for (auto& b : batches | vws::take(used)) {
+        staging.insert(staging.end(), b.vertices.begin(), b.vertices.end());
+        rect_staging.insert(rect_staging.end(), b.rects.begin(), b.rects.end());
+        glyph_staging.insert(glyph_staging.end(), b.glyphs.begin(), b.glyphs.end());
+    }
+
+    if (not staging.empty()) {
+        if (not vao) {
+            vao.emplace(VertexLayout::Batch);
+            vbo = &vao->add_buffer();
+        }
+
+        vbo->stream(staging);
+    }
+
+    if (not rect_staging.empty()) {
+        if (not rect_vao) {
+            rect_vao.emplace(VertexLayout::RectInstance);
+            rect_vbo = &rect_vao->add_buffer();
+        }
+
+        rect_vbo->stream(rect_staging);
+    }
+
+    if (not glyph_staging.empty()) {
+        if (not glyph_vao) {
+            glyph_vao.emplace(VertexLayout::GlyphInstance);
+            glyph_vbo = &glyph_vao->add_buffer();
+        }
+
+        glyph_vbo->stream(glyph_staging);
+    }
+
+    // Batches are sorted by state as far as that is possible, so
+    // neighbouring batches mostly share the shader and texture; any
+    // redundant binds are skipped by the state cache.
+    GLint first = 0;
+    usz first_rect = 0;
+    usz first_glyph = 0;
+    for (auto& b : batches | vws::take(used)) {
+        b.key.shader->use_shader_program_dont_call_this_directly();
+        if (b.key.texture) b.key.texture->bind();
+
+        // The rectangle and text shaders generate the corners of each
+        // quad themselves, so we only need to tell them which instances
+        // to draw.
+        switch (b.key.kind) {
+            case Kind::Vertices: {
+                auto count = GLsizei(b.vertices.size());
+                vao->bind();
+                glDrawArrays(b.key.mode, first, count);
+                first += count;
+            } break;
+
+            case Kind::Rects: {
+                auto count = GLsizei(b.rects.size());
+                rect_vao->rebase(first_rect);
+                glDrawArraysInstanced(b.key.mode, 0, 4, count);
+                first_rect += b.rects.size();
+            } break;
+
+            case Kind::Glyphs: {
+                auto count = GLsizei(b.glyphs.size());
+                glyph_vao->rebase(first_glyph);
+                glDrawArraysInstanced(b.key.mode, 0, 4, count);
+                first_glyph += b.glyphs.size();
+            } break;
+        }
+    }
+}
+
 // =============================================================================
 //  Drawing
 // =============================================================================
 void Renderer::clear(Colour c) {
-    auto [sx, sy] = size();
-    glViewport(0, 0, sx, sy);
+    Flush();
+    SetViewport(size());
     glClearColor(c.r, c.g, c.b, c.a);
     glClear(GL_COLOR_BUFFER_BIT);
 }
 
-void Renderer::draw_arrow(xy start_pos, xy end_pos, i32 thickness, Colour c) {
-    use(primitive_shader, {});
-    primitive_shader.uniform("in_colour", c.vec4());
+void Renderer::Draw(
+    ShaderProgram& shader,
+    const Texture* texture,
+    GLenum mode,
+    xy origin,
+    std::span<const vec4> verts,
+    Colour c,
+    vec4 params
+) {
+    if (verts.empty()) return;
+
+    // Transform the vertices to screen coordinates.
+    auto m = glm::translate(matrix_stack.back(), {origin.x, origin.y, 0});
+    auto Transform = [&](vec4 v) { return vec2(m * vec4(v.x, v.y, 0, 1)); };
+
+    // Antialiasing may touch pixels just outside the geometry, so
+    // pad the bounding box a bit.
+    Batcher::Bounds bounds{Transform(verts.front()), Transform(verts.front())};
+    for (auto v : verts | vws::drop(1)) bounds.merge({Transform(v), Transform(v)});
+    bounds.min -= 1;
+    bounds.max += 1;
+
+    auto colour = c.vec4();
+    auto& out = batcher.add({&shader, texture, mode}, bounds);
+    for (auto v : verts) out.push_back({vec4(Transform(v), v.z, v.w), colour, params});
+}
 
+void Renderer::DrawRect(xy pos, Size size, Colour c, i32 border_radius, Size thickness) {
+    // The matrix stack only ever translates and scales uniformly, so we
+    // can transform the rectangle by hand; the shader then computes the
+    // rounded corners in screen space.
+    auto& m = matrix_stack.back();
+    auto scale = m[0][0];
+    auto origin = vec2(m * vec4(pos.vec(), 0, 1));
+    auto sz = size.vec() * scale;
+
+    // Antialiasing may touch pixels just outside the rectangle.
+    Batcher::Bounds bounds{origin - 1.f, origin + sz + 1.f};
+    batcher.add_rect(rect_shader, bounds).push_back({
+        vec4(origin, sz),
+        c.vec4(),
+        vec4(f32(border_radius) * scale, thickness.vec() * scale, 0),
+    });
+}
+
+void Renderer::DrawQuad(
+    ShaderProgram& shader,
+    const Texture* texture,
+    xy origin,
+    const std::array<vec4, 4>& strip,
+    Colour c,
+    vec4 params
+) {
+    // Quads are batched as plain triangles so that neighbouring
+    // quads can be drawn in the same call.
+    vec4 verts[]{
+        strip[0], strip[1], strip[2],
+        strip[2], strip[1], strip[3],
+    };
+
+    Draw(shader, texture, GL_TRIANGLES, origin, verts, c, params);
+}
+
+void Renderer::draw_arrow(xy start_pos, xy end_pos, i32 thickness, Colour c) {
     // A thickness of 1 doesn’t work w/ our algorithm that extrudes
     // halfway to either side, so clamp it to at least 2.
     thickness = std::max(thickness, 2);
@@ -835,27 +1430,20 @@ void Renderer::draw_arrow(xy start_pos, xy end_pos, i32 thickness, Colour c) {
     auto a2 = start + n2 * (thickness / 2.f);
     auto a3 = end + n2 * (thickness / 2.f);
     auto a4 = end + n1 * (thickness / 2.f);
-    VertexArrays vao{VertexLayout::Position2D};
-    vec2 verts[] {
+    vec4 verts[] {
         // start -> end
-        a1, a2, a3,
-        a3, a4, a1,
+        {a1, 0, 0}, {a2, 0, 0}, {a3, 0, 0},
+        {a3, 0, 0}, {a4, 0, 0}, {a1, 0, 0},
         // head
-        head_end, h1, h2,
+        {head_end, 0, 0}, {h1, 0, 0}, {h2, 0, 0},
     };
 
-    vao.add_buffer(verts, GL_TRIANGLES);
-    vao.draw_vertices();
+    Draw(primitive_shader, nullptr, GL_TRIANGLES, {}, verts, c);
 }
 
 void Renderer::draw_line(xy start, xy end, Colour c) {
-    glLineWidth(1);
-    use(primitive_shader, {});
-    primitive_shader.uniform("in_colour", c.vec4());
-    VertexArrays vao{VertexLayout::Position2D};
-    vec2 verts[]{start.vec(), end.vec()};
-    vao.add_buffer(verts, GL_LINES);
-    vao.draw_vertices();
+    vec4 verts[]{{start.vec(), 0, 0}, {end.vec(), 0, 0}};
+    Draw(primitive_shader, nullptr, GL_LINES, {}, verts, c);
 }
 
 void Renderer::draw_outline_rect(
@@ -864,130 +1452,101 @@ void Renderer::draw_outline_rect(
     Colour c,
     i32 border_radius
 ) {
+    // The rectangle shader can only draw the inside of a rectangle,
+    // so grow 'box' by the thickness of the outline to get an outline
+    // around what the user passed in.
     box = box.grow(thickness.wd, thickness.ht);
-    auto pos = box.origin();
-    auto size = box.size();
-    auto [wd, ht] = size;
-    auto [tx, ty] = thickness;
-    use(rect_shader, pos);
-    rect_shader.uniform("in_colour", c.vec4());
-    rect_shader.uniform("size", size.vec());
-    rect_shader.uniform("radius", border_radius);
-    VertexArrays vao{VertexLayout::Position2D};
-
-    // Draw four rectangles around the original rectangle.
-    //
-    // These vertices actually draw a rectangle *inside* 'box', but
-    // we grow 'box' by the thickness of the outline, so the result
-    // is an outline around what the user passed in.
-    //
-    // We do it this way because the rectangle shader can only draw
-    // the inside of a rectangle.
-    vec2 verts[]{
-        // Left, inner.
-        {0, ty},
-        {tx, ty},
-        {tx, ht - ty},
-        {tx, ht - ty},
-        {0, ty},
-        {0, ht - ty},
-
-        // Right, inner.
-        {wd - tx, 0},
-        {wd, 0},
-        {wd - tx, ht},
-        {wd - tx, ht},
-        {wd, 0},
-        {wd, ht},
-
-        // Top, outer.
-        {0, ht - ty},
-        {0, ht},
-        {wd, ht - ty},
-        {wd, ht - ty},
-        {0, ht},
-        {wd, ht},
-
-        // Bottom, outer.
-        {0, 0},
-        {0, ty},
-        {wd, ty},
-        {wd, ty},
-        {0, 0},
-        {wd, 0},
-    };
-
-    vao.add_buffer(verts, GL_TRIANGLES);
-    vao.draw_vertices();
+    DrawRect(box.origin(), box.size(), c, border_radius, thickness);
 }
 
 void Renderer::draw_rect(xy pos, Size size, Colour c, i32 border_radius) {
-    use(rect_shader, pos);
-    rect_shader.uniform("in_colour", c.vec4());
-    rect_shader.uniform("size", size.vec());
-    rect_shader.uniform("radius", border_radius);
-    VertexArrays vao{VertexLayout::Position2D};
-    vec2 verts[]{
-        {0, 0},
-        {size.wd, 0},
-        {0, size.ht},
-        {size.wd, size.ht}
-    };
-    vao.add_buffer(verts, GL_TRIANGLE_STRIP);
-    vao.draw_vertices();
+    DrawRect(pos, size, c, border_radius, {});
 }
 
 void Renderer::draw_text(
     const Text& text,
     xy pos,
-    Colour colour
+    Colour c
 ) {
     if (text.empty) return;
+    auto ptr = text.drawable();
+    if (not ptr or ptr->glyphs.empty()) return;
+    auto& shaped = *ptr;
+
+    // As for rectangles, the matrix stack only ever translates and
+    // scales uniformly, so we can transform the glyphs by hand.
+    auto& m = matrix_stack.back();
+    auto scale = m[0][0];
+    auto origin = vec2(m * vec4(pos.vec(), 0, 1));
+    auto GlyphBox = [&](const ShapedText::Glyph& g) {
+        auto size = vec2(g.atlas.z, g.atlas.w) * shaped.scale * scale;
+        return vec4(origin + g.pos * scale, size);
+    };
 
-    // Initialise the text shader.
-    use(text_shader, pos);
-    text_shader.uniform("text_colour", colour.vec4());
-    text_shader.uniform("atlas_height", text.font.atlas_height());
+    auto GlyphBounds = [&](const ShapedText::Glyph& g) {
+        auto box = GlyphBox(g);
+        return Batcher::Bounds{vec2(box), vec2(box) + vec2(box.z, box.w)};
+    };
 
-    // Bind the font atlas.
-    text.font.use();
+    // Text is batched like everything else, so all text that uses
+    // the same font atlas is drawn at once.
+    auto bounds = GlyphBounds(shaped.glyphs.front());
+    for (auto& g : shaped.glyphs | vws::drop(1)) bounds.merge(GlyphBounds(g));
 
-    // Dew it.
-    text.draw_vertices();
+    glm::u8vec4 colour{c.r8, c.g8, c.b8, c.a8};
+    auto& out = batcher.add_glyphs(text_shader, text.font.atlas(), bounds);
+    for (auto& g : shaped.glyphs) out.push_back({GlyphBox(g), g.atlas, colour});
 }
 
 void Renderer::draw_texture(
     const DrawableTexture& tex,
     xy pos
 ) {
-    use(image_shader, pos);
-    tex.draw_vertices();
+    DrawQuad(image_shader, &tex, pos, tex.create_vertices(tex.size), Colour::White);
 }
 
 void Renderer::draw_texture_scaled(const DrawableTexture& tex, xy pos, f32 scale) {
-    use(image_shader, pos);
-    tex.bind();
-    VertexArrays vao{VertexLayout::PositionTexture4D};
-    vao.add_buffer(tex.create_vertices_scaled(scale), GL_TRIANGLE_STRIP);
-    vao.draw_vertices();
+    DrawQuad(image_shader, &tex, pos, tex.create_vertices_scaled(scale), Colour::White);
 }
 
 void Renderer::draw_texture_sized(const DrawableTexture& tex, AABB box) {
-    use(image_shader, box.origin());
-    tex.bind();
-    VertexArrays vao{VertexLayout::PositionTexture4D};
-    vao.add_buffer(tex.create_vertices(box.size()), GL_TRIANGLE_STRIP);
-    vao.draw_vertices();
+    DrawQuad(image_shader, &tex, box.origin(), tex.create_vertices(box.size()), Colour::White);
+}
+
+void Renderer::draw_texture_region(const DrawableTexture& tex, xy pos, AABB region) {
+    // Regions that we rendered into are not flipped vertically,
+    // unlike images loaded from files.
+    auto wd = f32(region.width()), ht = f32(region.height());
+    auto uv0 = region.min.vec() / tex.size.vec();
+    auto uv1 = region.max.vec() / tex.size.vec();
+    std::array strip{
+        vec4{0, 0, uv0.x, uv0.y},
+        vec4{wd, 0, uv1.x, uv0.y},
+        vec4{0, ht, uv0.x, uv1.y},
+        vec4{wd, ht, uv1.x, uv1.y},
+    };
+
+    DrawQuad(image_shader, &tex, pos, strip, Colour::White, {f32(tex.premultiplied), 0, 0, 0});
+}
+
+void Renderer::Flush() {
+    batcher.flush();
 }
 
 void Renderer::frame_end() {
+    Flush();
+
     // Swap buffers.
     check SDL_GL_SwapWindow(*window);
+    RecordGLCalls();
 }
 
 void Renderer::frame_start() {
     clear(DefaultBGColour);
 
+    // Pick up any text that was shaped in the background.
+    _text_shaped = text_shaper->poll(text_cache);
+
     // Disable mouse capture if the debugger is running.
     if (libassert::is_debugger_present()) {
         check SDL_SetHint(SDL_HINT_MOUSE_AUTO_CAPTURE, "0");
@@ -1001,15 +1560,28 @@ void Renderer::frame_start() {
     }
 }
 
-void Renderer::use(ShaderProgram& shader, xy position) {
-    auto [sx, sy] = size();
-    shader.use_shader_program_dont_call_this_directly();
+void Renderer::PopRenderTarget() {
+    Flush();
+    glDisable(GL_SCISSOR_TEST);
+    Framebuffer::BindDefault();
+    SetViewport(size());
+    matrix_stack.pop_back();
+    in_render_target = false;
+}
 
-    auto m = matrix_stack.back();
-    m = glm::translate(m, {position.x, position.y, 0});
-    m = glm::ortho<f32>(0, sx, 0, sy) * m;
+void Renderer::SetViewport(Size sz) {
+    glViewport(0, 0, sz.wd, sz.ht);
+    frame_uniforms->store(FrameUniforms{
+        .projection = glm::ortho<f32>(0, f32(sz.wd), 0, f32(sz.ht)),
+        .window_size = sz.vec(),
+    });
+}
 
-    shader.uniform("transform", m);
+void Renderer::use(ShaderProgram& shader, xy position) {
+    Flush();
+    shader.use_shader_program_dont_call_this_directly();
+    auto m = glm::translate(matrix_stack.back(), {position.x, position.y, 0});
+    shader.uniform("model", m);
 }
 
 // =============================================================================
@@ -1032,6 +1604,27 @@ auto Renderer::font(FontSize size, TextStyle style) -> Font& {
 
 auto Renderer::frame() -> Frame { return Frame(*this); }
 
+auto Renderer::push_render_target(Framebuffer& fb, AABB region) -> RenderTargetRAII {
+    Assert(not in_render_target, "Render targets cannot be nested");
+    in_render_target = true;
+
+    // Anything drawn so far goes to the window.
+    Flush();
+    fb.bind();
+    SetViewport(fb.size);
+
+    // Clear the region and make sure we don’t draw outside of it.
+    auto [wd, ht] = region.size();
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(region.min.x, region.min.y, wd, ht);
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // Start drawing at the region’s origin, ignoring the current matrix.
+    matrix_stack.push_back(glm::translate(mat4(1.f), {region.min.x, region.min.y, 0}));
+    return RenderTargetRAII{*this};
+}
+
 auto Renderer::push_matrix(xy translate, f32 scale) -> MatrixRAII {
     auto m = matrix_stack.back();
     m = glm::translate(m, {translate.x, translate.y, 0});
@@ -1050,10 +1643,10 @@ void Renderer::reload_shaders() {
 
     auto Reload = [&](ShaderProgram& program, std::string_view shader_name) {
         auto res = ReloadImpl(program, shader_name);
-        if (not res) Log("Error loading shader '{}': {}", shader_name, res.error());
+        if (not res) Log<LogLevel::Error, LogCategory::Render>("Error loading shader '{}': {}", shader_name, res.error());
     };
 
-    Log("Loading shaders...");
+    Log<LogLevel::Info, LogCategory::Render>("Loading shaders...");
     Reload(primitive_shader, "Primitive");
     Reload(text_shader, "Text");
     Reload(image_shader, "Image");
@@ -1081,10 +1674,30 @@ auto Renderer::text(
     std::vector<TextCluster>* clusters
 ) -> Text {
     Text t{font(size, style), std::move(value), align};
-    t.font.shape(t, clusters);
+    t.shaped = text_cache.shape(t, clusters);
     return t;
 }
 
+void Renderer::RecordGLCalls() {
+    auto& counters = GLState::Get().counters;
+    _frame_gl_calls = std::exchange(counters, {});
+    gl_calls.frames++;
+    gl_calls.total.calls += frame_gl_calls.calls;
+    gl_calls.total.skipped += frame_gl_calls.skipped;
+
+    // Report the average every once in a while.
+    auto now = SDL_GetTicks();
+    if (now - gl_calls.last_report < GLCallReportIntervalMs) return;
+    auto frames = f64(gl_calls.frames);
+    Log<LogLevel::Debug, LogCategory::Render>(
+        "OpenGL calls per frame: {:.1f}, {:.1f} redundant calls skipped",
+        f64(gl_calls.total.calls) / frames,
+        f64(gl_calls.total.skipped) / frames
+    );
+
+    gl_calls = {.last_report = now};
+}
+
 void Renderer::SetCursorImpl() {
     auto it = cursor_cache.find(active_cursor);
     if (it != cursor_cache.end()) {
@@ -1123,32 +1736,29 @@ auto AABB::contains(xy pos) const -> bool {
 // The renderer parameter is unused and is only passed in
 // to ensure that we create the renderer before the asset
 // loader.
-auto AssetLoader::Create() -> Thread<AssetLoader> {
-    return Thread<AssetLoader>{&Load};
+auto AssetLoader::Create(std::string prewarm) -> Thread<AssetLoader> {
+    return Thread<AssetLoader>{&Load, std::move(prewarm)};
 }
 
-auto AssetLoader::Load(std::stop_token stop) -> AssetLoader {
+auto AssetLoader::Load(const std::string& prewarm, std::stop_token stop) -> AssetLoader {
     AssetLoader loader;
-    loader.load(stop);
+    loader.load(prewarm, stop);
     return loader;
 }
 
-void AssetLoader::load(std::stop_token stop) {
+void AssetLoader::load(std::string_view prewarm, std::stop_token stop) {
     using enum TextStyle;
 
     // Load the font faces.
     for (auto f : {Regular, Italic, Bold, BoldItalic}) {
         if (stop.stop_requested()) return;
-        ftcall FT_Init_FreeType(&*font_data.ft[+f]);
-        ftcall FT_New_Memory_Face(
-            *font_data.ft[+f],
-            reinterpret_cast<const FT_Byte*>(Fonts[+f].data()),
-            Fonts[+f].size(),
-            0,
-            &*font_data.ft_face[+f]
-        );
+        LoadFace(Fonts[+f], font_data.ft[+f], font_data.ft_face[+f]);
     }
 
+    // Glyphs are shared between all sizes of a style.
+    for (auto s : {Regular, Italic, Bold, BoldItalic})
+        font_data.atlases[+s] = std::make_unique<GlyphAtlas>(*font_data.ft_face[+s], Fonts[+s]);
+
     // Load each predefined font.
     for (
         auto f : {
@@ -1162,9 +1772,32 @@ void AssetLoader::load(std::stop_token stop) {
             FontSize::Gargantuan,
         }
     ) {
-        for (auto s : {Regular, Italic, Bold, BoldItalic})
-            font_data.fonts[{+f, s}] = Font{*font_data.ft_face[+s], f, s};
+        for (auto s : {Regular, Italic, Bold, BoldItalic}) {
+            auto& font = font_data.fonts[{+f, s}] = Font{*font_data.ft_face[+s], f, s};
+            font.glyph_atlas = font_data.atlases[+s].get();
+        }
     }
+
+    // Rasterise the glyphs of text we know we’ll need. Glyphs are shared
+    // between all sizes of a style, so shaping the text once is enough;
+    // only the regular style is used by the UI at the moment.
+    if (stop.stop_requested()) return;
+    auto& font = font_data.fonts[{+FontSize::Normal, Regular}];
+    font.shape(
+        TextKey{
+            .content = text::ToUTF32(prewarm),
+            .font = &font,
+            .align = TextAlign::Left,
+            .reflow = Reflow::None,
+            .desired_width = 0,
+        },
+        nullptr
+    );
+
+    Log<LogLevel::Debug, LogCategory::Render>(
+        "Rasterised {} glyphs ahead of time",
+        font_data.atlases[+Regular]->glyphs.size()
+    );
 }
 
 /// Finish loading assets.
@@ -1172,10 +1805,13 @@ void AssetLoader::finalise(Renderer& r) {
     // Move resources.
     r.font_data = std::move(font_data);
 
-    // Build font textures.
+    // Finish initialising the fonts.
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    for (auto& f : r.font_data.fonts | vws::values) {
-        f._renderer = &r;
-        f.atlas_width = Texture::MaxSize();
+    for (auto& f : r.font_data.fonts | vws::values) f._renderer = &r;
+    for (auto& a : r.font_data.atlases) {
+        a->max_atlas_size = std::min(GlyphAtlas::MaxAtlasSize, Texture::MaxSize());
+
+        // Upload everything we rasterised while loading in one go.
+        a->texture();
     }
 }
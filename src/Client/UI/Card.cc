@@ -284,17 +284,113 @@ LateInit<DrawableTexture> LockedTexture;
 /// The card shadow texture.
 LateInit<DrawableTexture> CardShadow;
 
+/// Cache of fully drawn cards.
+///
+/// A card only changes when its id, scale, or variant does, so we draw
+/// each combination once into a shared atlas and then draw the card as
+/// a single textured quad, which also lets consecutive cards share a
+/// draw call. Anything that changes more often, i.e. the shadow, the
+/// selection outline, and the inactive overlay, is drawn on top.
+class CardCache {
+    LIBBASE_IMMOVABLE(CardCache);
+
+    /// The width and height of the atlas; this fits everything that is
+    /// usually on screen at the same time several times over.
+    static constexpr i32 AtlasSize = 2'048;
+
+    /// Gap between entries so linear filtering doesn’t bleed
+    /// neighbouring cards into each other.
+    static constexpr i32 Gap = 2;
+
+    /// Where each card is in the atlas.
+    HashMap<u32, AABB> entries;
+
+    /// The atlas is filled row by row; this is where the next entry
+    /// goes and how tall the current row is.
+    xy cursor;
+    i32 row_height = 0;
+
+public:
+    DrawableTexture atlas;
+    Framebuffer framebuffer;
+
+    CardCache();
+
+    /// Get the key for a card.
+    static auto Key(CardId id, Card::Scale scale, Card::Variant variant) -> u32;
+
+    /// Look up a card.
+    auto find(u32 key) const -> std::optional<AABB>;
+
+    /// Allocate space for a card. If the atlas is full, this evicts
+    /// everything else.
+    auto insert(u32 key, Size sz) -> AABB;
+};
+
+CardCache::CardCache()
+    : atlas{nullptr, u32(AtlasSize), u32(AtlasSize), GL_RGBA, GL_UNSIGNED_BYTE},
+      framebuffer{atlas} {
+    atlas.premultiplied = true;
+}
+
+auto CardCache::Key(CardId id, Card::Scale scale, Card::Variant variant) -> u32 {
+    return u32(+id) << 16 | u32(scale) << 8 | u32(+variant);
+}
+
+auto CardCache::find(u32 key) const -> std::optional<AABB> {
+    auto it = entries.find(key);
+    if (it == entries.end()) return std::nullopt;
+    return it->second;
+}
+
+auto CardCache::insert(u32 key, Size sz) -> AABB {
+    if (cursor.x + sz.wd > AtlasSize) {
+        cursor = {0, cursor.y + row_height + Gap};
+        row_height = 0;
+    }
+
+    // Cards that were already drawn this frame have been submitted
+    // by the time we overwrite them, so we can just start over.
+    if (cursor.y + sz.ht > AtlasSize) {
+        Log<LogLevel::Debug, LogCategory::Render>("Card cache is full; evicting {} cards", entries.size());
+        entries.clear();
+        cursor = {};
+        row_height = 0;
+    }
+
+    AABB region{cursor, sz};
+    cursor.x += sz.wd + Gap;
+    row_height = std::max(row_height, sz.ht);
+    entries[key] = region;
+    return region;
+}
+
+LateInit<CardCache> Cache;
+
 // This only takes a renderer to ensure that it is called
 // after the renderer has been initialised.
 void client::InitialiseUI(Renderer&) {
     LockedTexture.init(DrawableTexture::LoadFromFile("assets/locked.webp"));
     CardShadow.init(DrawableTexture::LoadFromFile("assets/shadow.webp"));
+    Cache.init();
     SilenceLog _;
     for (auto& p : PowerCardDatabase) {
         p.image.init(DrawableTexture::LoadFromFile(fs::Path{"assets/Cards"} / p.image_path));
     }
 }
 
+auto client::PrewarmText() -> std::string {
+    // Printable ASCII covers most of the rest of the UI; the arrow
+    // is used in the descriptions of sound cards.
+    std::string text = "→\n";
+    for (char c = ' '; c <= '~'; c++) text += c;
+
+    // Add all text that can appear on a card.
+    for (auto& c : CardDatabase) std::format_to(std::back_inserter(text), "\n{}\n{}", c.name, c.center);
+    for (auto& p : PowerCardDatabase) std::format_to(std::back_inserter(text), "\n{}\n{}", p.rules, p.extended_rules);
+    return text;
+}
+
 // =============================================================================
 //  Card
 // =============================================================================
@@ -323,13 +419,24 @@ void Card::draw(Renderer& r) {
         r.draw_texture(*CardShadow, {-20, -20});
     }
 
-    auto colour = variant == Variant::Regular ? outline_colour
-                : variant == Variant::Added   ? alternate_colour
-                : variant == Variant::Ghost   ? Colour{222, 222, 222, 255}
-                                              : outline_colour.darken(.2f);
+    // Draw the card into the cache if it isn’t already in there; until
+    // its text has been shaped and laid out, draw it directly instead
+    // so we don’t end up caching the placeholder.
+    if (not laid_out or TextPending()) {
+        DrawCard(r);
+    } else {
+        auto key = CardCache::Key(id, scale, variant);
+        auto region = Cache->find(key);
+        if (not region) {
+            region = Cache->insert(key, CardSize[scale]);
+            auto _ = r.push_render_target(Cache->framebuffer, *region);
+            DrawCard(r);
+        }
+
+        r.draw_texture_region(Cache->atlas, {}, *region);
+    }
 
     AABB rect{{0, 0}, CardSize[scale]};
-    r.draw_rect(rect, colour.lighten(.1f), BorderRadius[scale]);
     if (selected) r.draw_outline_rect(
         rect,
         CardStacks::CardGaps[scale] / 2,
@@ -337,6 +444,26 @@ void Card::draw(Renderer& r) {
         BorderRadius[scale]
     );
 
+    // Draw a white rectangle on top of this card if it is inactive.
+    if (overlay == Overlay::Inactive) r.draw_rect(
+        rect,
+        Colour{255, 255, 255, 200},
+        BorderRadius[scale]
+    );
+
+    // TODO: Sounds that have been deleted or added to the word
+    //       should be greyed out / orange (or a plus in the corner),
+    //       respectively.
+}
+
+void Card::DrawCard(Renderer& r) {
+    auto colour = variant == Variant::Regular ? outline_colour
+                : variant == Variant::Added   ? alternate_colour
+                : variant == Variant::Ghost   ? Colour{222, 222, 222, 255}
+                                              : outline_colour.darken(.2f);
+
+    AABB rect{{0, 0}, CardSize[scale]};
+    r.draw_rect(rect, colour.lighten(.1f), BorderRadius[scale]);
     r.draw_outline_rect(
         rect.shrink(Border[scale].wd, Border[scale].ht),
         Size{Border[scale]},
@@ -362,17 +489,6 @@ void Card::draw(Renderer& r) {
         colour.darken(.1f),
         b
     );
-
-    // Draw a white rectangle on top of this card if it is inactive.
-    if (overlay == Overlay::Inactive) r.draw_rect(
-        rect,
-        Colour{255, 255, 255, 200},
-        BorderRadius[scale]
-    );
-
-    // TODO: Sounds that have been deleted or added to the word
-    //       should be greyed out / orange (or a plus in the corner),
-    //       respectively.
 }
 
 void Card::DrawChildren(Renderer& r) {
@@ -459,6 +575,18 @@ void Card::refresh(Renderer& r, bool full) {
     middle.refresh(r, full);
     description.refresh(r, full);
     image.refresh(r, full);
+
+    // If any text is still being shaped, we need another full refresh
+    // once it arrives to lay out our labels with their actual sizes.
+    laid_out = not TextPending();
+    if (not laid_out) needs_refresh = true;
+}
+
+auto Card::TextPending() const -> bool {
+    return code.text.pending or
+           name.text.pending or
+           middle.text.pending or
+           description.text.pending;
 }
 
 void Card::set_id(CardId ct) {
@@ -508,6 +636,7 @@ void Card::set_id(CardId ct) {
         image.texture = &*power.image;
     }
 
+    laid_out = false;
     needs_refresh = true;
 }
 
@@ -31,18 +31,23 @@ auto CenterTextInBox(
     i32 box_height,
     AABB absolute_box
 ) -> xy {
+    // Position whatever we’re going to draw; don’t shape text that is
+    // still being shaped in the background just to center it.
+    auto shaped = text.drawable();
+    if (text.empty or not shaped) return Position::Center().resolve(absolute_box, Size{});
+
     f32 ascender = text.font.strut_split().first;
     f32 strut = text.font.strut();
-    Size sz{text.width, f32(0)}; // Zero out the height to avoid it messing w/ up the calculation.
+    Size sz{shaped->width, f32(0)}; // Zero out the height to avoid it messing w/ up the calculation.
 
     // We need to add extra space for every line beyond the first.
     //
     // Note: This formula is known to be correct for 1–2 lines; it has not been tested
     // for more than 2 lines, so we might have to amend it at some point.
-    strut += ascender * (text.lines - 1);
+    strut += ascender * (shaped->lines - 1);
 
-    // Bail out if we don’t have enough space or if the text is empty.
-    if (text.empty or strut > box_height) return Position::Center().resolve(absolute_box, sz);
+    // Bail out if we don’t have enough space.
+    if (strut > box_height) return Position::Center().resolve(absolute_box, sz);
 
     // This calculation ‘centers’ text in the box at the baseline.
     //
@@ -145,7 +150,11 @@ void Label::draw(Renderer& r) {
         xy position = CenterTextInBox(text, fixed_height, bounding_box);
         r.draw_text(text, position, colour);
     } else {
-        xy position = auto{pos}.voffset(i32(text.depth)).resolve(parent.bounding_box, text.text_size);
+        // As above, don’t shape the text here if it isn’t done yet.
+        auto shaped = text.drawable();
+        if (not shaped) return;
+        Size sz{i32(shaped->width), i32(shaped->height + shaped->depth)};
+        xy position = auto{pos}.voffset(i32(shaped->depth)).resolve(parent.bounding_box, sz);
         r.draw_text(text, position, colour);
     }
 
@@ -157,13 +166,18 @@ void Label::draw(Renderer& r) {
 }
 
 void Label::refresh(Renderer&, bool) {
-    defer {
-        auto sz = text.text_size;
-        UpdateBoundingBox(Size{sz.wd, std::max(sz.ht, fixed_height)});
-    };
+    if (reflow != Reflow::None)
+        _text.desired_width = std::min(max_width, parent.bounding_box.width());
+
+    // Shape the text in the background; until it’s done, keep our
+    // current size. The screen refreshes us again once it arrives.
+    if (not _text.shape_in_background()) {
+        RefreshBoundingBox();
+        return;
+    }
 
-    if (reflow == Reflow::None) return;
-    _text.desired_width = std::min(max_width, parent.bounding_box.width());
+    auto sz = text.text_size;
+    UpdateBoundingBox(Size{sz.wd, std::max(sz.ht, fixed_height)});
 }
 
 void Label::update_text(std::string_view new_text) {
@@ -559,9 +559,13 @@ void Screen::refresh(Renderer& r) {
 
     // Size hasn’t changed. Still update any elements that
     // requested a refresh. Also ignore visibility here.
+    //
+    // If text that was being shaped in the background has arrived,
+    // refresh everything: the widgets that were waiting for it may be
+    // nested in groups that have already cleared their refresh flag.
     if (prev_size == r.size()) {
         for (auto& e : widgets)
-            if (e.needs_refresh)
+            if (e.needs_refresh or r.text_shaped)
                 RefreshElement(r, e);
         return;
     }
@@ -682,7 +686,7 @@ void InputSystem::game_loop(std::function<void()> tick) {
             );
         } else {
 #ifndef PRESCRIPTIVISM_ENABLE_SANITISERS
-            Log("Client tick took too long: {}ms", tick_duration.count());
+            Log<LogLevel::Warning, LogCategory::UI>("Client tick took too long: {}ms", tick_duration.count());
 #endif
         }
     }
@@ -0,0 +1,270 @@
+#include <Headless/Game.hh>
+
+#include <Shared/Validation.hh>
+
+#include <base/Base.hh>
+
+#include <algorithm>
+#include <format>
+#include <ranges>
+#include <utility>
+
+using namespace pr;
+using namespace pr::headless;
+namespace sc = packets::sc;
+namespace cs = packets::cs;
+
+// =============================================================================
+//  Actions
+// =============================================================================
+void Game::answer_card_choice(std::vector<u32> card_indices) {
+    Assert(
+        _challenge and _challenge->get_if<packets::CardChoiceChallenge>(),
+        "No card choice challenge to answer"
+    );
+
+    _challenge = std::nullopt;
+    Send(cs::CardChoiceReply{std::move(card_indices)});
+}
+
+void Game::answer_negation(bool negate) {
+    Assert(_challenge and _challenge->get_if<NegationPrompt>(), "No negation prompt to answer");
+    _challenge = std::nullopt;
+    Send(cs::PromptNegationReply{negate});
+}
+
+void Game::choose_word(const constants::Word& word) {
+    Assert(_phase == Phase::ChoosingWord, "Not choosing a word");
+    _phase = Phase::Waiting;
+    Send(cs::WordChoice{word});
+}
+
+void Game::login(std::string name, std::string password) {
+    Send(cs::Login{std::move(name), std::move(password)});
+}
+
+void Game::play(const Move& move) {
+    Assert(_our_turn, "Not our turn");
+    Assert(not _challenge, "Must answer the active challenge first");
+    move.visit([&](const auto& packet) { Send(packet); });
+}
+
+// =============================================================================
+//  Queries
+// =============================================================================
+auto Game::legal_moves() const -> std::vector<Move> {
+    std::vector<Move> moves;
+    if (not _our_turn or _challenge) return moves;
+
+    // Add a move for every stack of every player on which a card can be played.
+    auto AddTargets = [&](u32 index, auto pred) {
+        for (auto& p : _players) {
+            auto v = validator(p.id);
+            for (usz s = 0; s < p.word.size(); s++)
+                if (pred(v, s))
+                    moves.emplace_back(cs::PlaySingleTarget{index, p.id, u32(s)});
+        }
+    };
+
+    for (auto [i, card] : _hand | vws::enumerate) {
+        auto index = u32(i);
+        if (card.is_sound()) {
+            // Don’t offer sound changes that need another card; the
+            // protocol has no way to play those yet.
+            AddTargets(index, [&](const Validator& v, usz s) {
+                auto res = validation::ValidatePlaySoundCard(card, v, s);
+                return res == validation::PlaySoundCardValidationResult::Valid;
+            });
+            continue;
+        }
+
+        switch (card.value) {
+            default: break;
+
+            // Always playable.
+            case CardId::P_Babel:
+            case CardId::P_Whorf:
+                moves.emplace_back(cs::PlayNoTarget{index});
+                break;
+
+            // Targets another player.
+            case CardId::P_Superstratum:
+                for (auto& p : _players)
+                    if (p.id != _id)
+                        moves.emplace_back(cs::PlayPlayerTarget{index, p.id});
+                break;
+
+            case CardId::P_Descriptivism:
+                AddTargets(index, [](const Validator& v, usz s) {
+                    return validation::ValidateP_Descriptivism(v, s);
+                });
+                break;
+
+            case CardId::P_SpellingReform:
+                AddTargets(index, [](const Validator& v, usz s) {
+                    return validation::ValidateP_SpellingReform(v, s);
+                });
+                break;
+        }
+    }
+
+    return moves;
+}
+
+// =============================================================================
+//  Packet Handlers
+// =============================================================================
+auto Game::receive(net::ReceiveBuffer& buf) -> Result<> {
+    while (_phase != Phase::Disconnected and not buf.empty()) {
+        auto complete = Try(packets::HandleClientSidePacket(*this, *this, buf));
+        if (not invalid_packet.empty()) return Error("{}", std::exchange(invalid_packet, {}));
+        if (not complete) break;
+    }
+    return {};
+}
+
+bool Game::CheckStack(PlayerId player, u32 stack_index, std::string_view packet) {
+    if (player < _players.size() and stack_index < _players[player].word.size()) return true;
+    invalid_packet = std::format("{} refers to stack {} of player {}, which doesn’t exist", packet, stack_index, player);
+    return false;
+}
+
+void Game::handle(sc::Disconnect packet) {
+    _phase = Phase::Disconnected;
+    _our_turn = false;
+    if (observer) observer->on_disconnect(packet.reason);
+}
+
+void Game::handle(sc::HeartbeatRequest req) {
+    Send(cs::HeartbeatResponse{req.seq_no});
+}
+
+void Game::handle(sc::WordChoice wc) {
+    _phase = Phase::ChoosingWord;
+    _dealt_word = wc.word;
+    if (observer) observer->on_word_choice(_dealt_word);
+}
+
+void Game::handle(sc::StartGame sg) {
+    _phase = Phase::Running;
+    _id = sg.player_id;
+    _our_turn = false;
+    _challenge = std::nullopt;
+    _hand = std::move(sg.hand);
+    _players.clear();
+    for (auto [i, data] : sg.player_data | vws::enumerate) {
+        auto& p = _players.emplace_back(PlayerId(i), std::move(data.name));
+        for (auto c : data.word) p.word.push_back(Stack{{c}});
+    }
+
+    if (observer) observer->on_start_game();
+}
+
+void Game::handle(sc::StartTurn) {
+    _our_turn = true;
+    if (observer) observer->on_start_turn();
+}
+
+void Game::handle(sc::EndTurn) {
+    _our_turn = false;
+    if (observer) observer->on_end_turn();
+}
+
+void Game::handle(sc::Draw dr) {
+    _hand.push_back(dr.card);
+    if (observer) observer->on_card_drawn(dr.card);
+}
+
+void Game::handle(sc::AddSoundToStack add) {
+    if (not CheckStack(add.player, add.stack_index, "AddSoundToStack")) return;
+    _players[add.player].word[add.stack_index].cards.push_back(add.card);
+    if (observer) observer->on_sound_added(add.player, add.stack_index, add.card);
+}
+
+void Game::handle(sc::StackLockChanged lock) {
+    if (not CheckStack(lock.player, lock.stack_index, "StackLockChanged")) return;
+    _players[lock.player].word[lock.stack_index].locked = lock.locked;
+    if (observer) observer->on_stack_lock_changed(lock.player, lock.stack_index, lock.locked);
+}
+
+void Game::handle(sc::WordChanged wc) {
+    // Every stack needs at least one card since we look at the top of it.
+    if (wc.player >= _players.size() or rgs::any_of(wc.new_word, [](auto& s) { return s.empty(); })) {
+        invalid_packet = std::format("WordChanged for player {} is invalid", wc.player);
+        return;
+    }
+
+    auto& w = _players[wc.player].word;
+    w.clear();
+    for (auto& s : wc.new_word) w.push_back(Stack{std::move(s)});
+    if (observer) observer->on_word_changed(wc.player, w);
+}
+
+void Game::handle(sc::DiscardAll) {
+    _hand.clear();
+    if (observer) observer->on_hand_discarded();
+}
+
+void Game::handle(sc::CardChoice c) {
+    _challenge = c.challenge;
+    if (observer) observer->on_card_choice(c.challenge);
+}
+
+void Game::handle(sc::RemoveCard r) {
+    if (r.card_index >= _hand.size()) {
+        invalid_packet = std::format("RemoveCard refers to card {} in our hand, which doesn’t exist", r.card_index);
+        return;
+    }
+
+    _hand.erase(_hand.begin() + r.card_index);
+    if (observer) observer->on_card_removed(r.card_index);
+}
+
+void Game::handle(sc::PromptNegation p) {
+    _challenge = NegationPrompt{p.card_id};
+    if (observer) observer->on_prompt_negation(p.card_id);
+}
+
+// =============================================================================
+//  Client
+// =============================================================================
+Client::Client(net::TCPConnexion conn, GameObserver* observer)
+    : conn(std::move(conn)),
+      game([this](std::span<const std::byte> data) { this->conn.send(data); }, observer) {}
+
+auto Client::Connect(
+    std::string address,
+    u16 port,
+    std::string name,
+    std::string password,
+    GameObserver* observer
+) -> Result<std::unique_ptr<Client>> {
+    auto conn = Try(net::TCPConnexion::Connect(std::move(address), port));
+    std::unique_ptr<Client> c{new Client(std::move(conn), observer)};
+    c->game.login(std::move(name), std::move(password));
+    return c;
+}
+
+bool Client::disconnected() {
+    return conn.disconnected;
+}
+
+void Client::disconnect() {
+    if (conn.disconnected) return;
+    conn.send(cs::Disconnect{DisconnectReason::Unspecified});
+    conn.disconnect();
+}
+
+void Client::tick() {
+    if (conn.disconnected) return;
+    conn.receive([&](net::ReceiveBuffer& buf) {
+        if (auto res = game.receive(buf); not res) {
+            Log<LogLevel::Warning, LogCategory::Net>("Invalid packet from server: {}", res.error());
+            conn.disconnect();
+        }
+    });
+
+    // Make sure the game knows if the server has gone away.
+    if (conn.disconnected and game.phase != Game::Phase::Disconnected)
+        game.handle(sc::Disconnect{DisconnectReason::Unspecified});
+}
@@ -0,0 +1,237 @@
+#include <Server/Admin.hh>
+
+#include <base/Base.hh>
+
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <string>
+
+#ifdef __linux__
+#    include <arpa/inet.h>
+#    include <netinet/in.h>
+#    include <sys/socket.h>
+#    include <sys/types.h>
+
+#    include <malloc.h>
+#    include <poll.h>
+#    include <unistd.h>
+#else
+#    error TODO: Non-linux support
+#endif
+
+using namespace pr;
+using namespace pr::server;
+
+// =============================================================================
+//  Stats
+// =============================================================================
+void Stats::record_action(chr::microseconds duration) {
+    auto us = u64(duration.count());
+    auto bucket = rgs::lower_bound(ActionHistogramBuckets, us);
+    action_histogram[usz(bucket - ActionHistogramBuckets.begin())]++;
+    action_count++;
+    action_duration_sum += us;
+}
+
+void Stats::record_tick(chr::microseconds duration, const AllocationStats& allocations) {
+    auto us = u64(duration.count());
+    auto bucket = rgs::lower_bound(TickHistogramBuckets, us);
+    tick_histogram[usz(bucket - TickHistogramBuckets.begin())]++;
+    tick_count++;
+    tick_duration_sum += us;
+    tick_allocations += allocations;
+    last_tick_allocations = allocations;
+}
+
+// =============================================================================
+//  Formatting
+// =============================================================================
+namespace {
+auto PacketName(usz index) -> std::string_view {
+    switch (packets::cs::ID(index)) {
+#define X(name) \
+    case packets::cs::ID::name: return #name;
+        CS_PACKETS(X)
+#undef X
+    }
+    Unreachable();
+}
+
+/// Get the resident set size of this process.
+auto ResidentMemory() -> u64 {
+    std::ifstream statm{"/proc/self/statm"};
+    u64 size = 0, resident = 0;
+    if (not(statm >> size >> resident)) return 0;
+    return resident * u64(::sysconf(_SC_PAGESIZE));
+}
+
+auto Render(const Stats& s) -> std::string {
+    std::string out;
+    auto Metric = [&](std::string_view name, std::string_view type, std::string_view help, auto value) {
+        out += std::format("# HELP prescriptivism_{} {}\n", name, help);
+        out += std::format("# TYPE prescriptivism_{} {}\n", name, type);
+        out += std::format("prescriptivism_{} {}\n", name, value);
+    };
+
+    // There is only ever one game per server at the moment.
+    Metric("rooms", "gauge", "Number of games hosted by this server.", 1);
+    Metric("game_running", "gauge", "Whether the game has started.", int(s.game_running));
+    Metric("players", "gauge", "Number of players in the game.", s.players);
+    Metric("players_connected", "gauge", "Number of players that are currently connected.", s.connected_players);
+    Metric("connexions", "gauge", "Number of open client connexions.", s.connexions);
+    Metric("pending_connexions", "gauge", "Number of connexions that have not logged in yet.", s.pending_connexions);
+    Metric("send_queue_bytes", "gauge", "Total number of bytes waiting to be sent to clients.", s.send_queue_bytes);
+    Metric("send_queue_max_bytes", "gauge", "Largest number of bytes waiting to be sent to a single client.", s.max_send_queue_bytes);
+    Metric("buffer_capacity_bytes", "gauge", "Total number of bytes allocated for connexion buffers.", s.buffer_capacity_bytes);
+    Metric("games_completed_total", "counter", "Number of games that have been played to completion.", s.games_completed);
+
+    // Packet counters; rates can be computed from these by the scraper.
+    out += "# HELP prescriptivism_packets_received_total Number of packets received from clients.\n";
+    out += "# TYPE prescriptivism_packets_received_total counter\n";
+    for (auto [i, count] : s.packets_received | vws::enumerate)
+        out += std::format("prescriptivism_packets_received_total{{type=\"{}\"}} {}\n", PacketName(usz(i)), count);
+
+    // Tick histogram. Prometheus expects cumulative buckets.
+    out += "# HELP prescriptivism_tick_duration_seconds Duration of server ticks.\n";
+    out += "# TYPE prescriptivism_tick_duration_seconds histogram\n";
+    u64 cumulative = 0;
+    for (auto [i, bound] : TickHistogramBuckets | vws::enumerate) {
+        cumulative += s.tick_histogram[usz(i)];
+        out += std::format("prescriptivism_tick_duration_seconds_bucket{{le=\"{}\"}} {}\n", bound / 1e6, cumulative);
+    }
+    out += std::format("prescriptivism_tick_duration_seconds_bucket{{le=\"+Inf\"}} {}\n", s.tick_count);
+    out += std::format("prescriptivism_tick_duration_seconds_sum {}\n", s.tick_duration_sum / 1e6);
+    out += std::format("prescriptivism_tick_duration_seconds_count {}\n", s.tick_count);
+
+    // Same for how long it takes to handle a game action.
+    out += "# HELP prescriptivism_action_duration_seconds Time spent handling game actions.\n";
+    out += "# TYPE prescriptivism_action_duration_seconds histogram\n";
+    cumulative = 0;
+    for (auto [i, bound] : ActionHistogramBuckets | vws::enumerate) {
+        cumulative += s.action_histogram[usz(i)];
+        out += std::format("prescriptivism_action_duration_seconds_bucket{{le=\"{}\"}} {}\n", bound / 1e6, cumulative);
+    }
+    out += std::format("prescriptivism_action_duration_seconds_bucket{{le=\"+Inf\"}} {}\n", s.action_count);
+    out += std::format("prescriptivism_action_duration_seconds_sum {}\n", s.action_duration_sum / 1e6);
+    out += std::format("prescriptivism_action_duration_seconds_count {}\n", s.action_count);
+
+    // Memory usage.
+    Metric("resident_memory_bytes", "gauge", "Resident set size of the server process.", ResidentMemory());
+    Metric("heap_allocated_bytes", "gauge", "Bytes currently allocated on the heap.", u64(::mallinfo2().uordblks));
+
+    // Allocation tracking.
+    if constexpr (AllocationTrackingEnabled) {
+        Metric("tick_allocations_total", "counter", "Number of allocations made during server ticks.", s.tick_allocations.allocations);
+        Metric("tick_allocated_bytes_total", "counter", "Number of bytes allocated during server ticks.", s.tick_allocations.bytes);
+        Metric("last_tick_allocations", "gauge", "Number of allocations made during the last server tick.", s.last_tick_allocations.allocations);
+        Metric("last_tick_allocated_bytes", "gauge", "Number of bytes allocated during the last server tick.", s.last_tick_allocations.bytes);
+        Metric("live_heap_bytes", "gauge", "Bytes currently allocated with operator new.", LiveHeapBytes());
+    }
+
+    return out;
+}
+} // namespace
+
+// =============================================================================
+//  Admin Server
+// =============================================================================
+AdminServer::AdminServer(int listener) : listener(listener) {
+    thread = std::jthread{[this](std::stop_token stop) { Run(stop); }};
+}
+
+AdminServer::~AdminServer() {
+    thread.request_stop();
+    if (thread.joinable()) thread.join();
+    ::close(listener);
+}
+
+auto AdminServer::Create(u16 port) -> Result<std::unique_ptr<AdminServer>> {
+    int sock = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (sock == -1) return Error("Failed to create admin socket: {}", std::strerror(errno));
+
+    int opt = 1;
+    ::setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof opt);
+
+    // Only ever listen on loopback; this is not meant to be reachable
+    // from the outside.
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(port);
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (
+        ::bind(sock, reinterpret_cast<sockaddr*>(&sa), sizeof sa) == -1 or
+        ::listen(sock, 8) == -1
+    ) {
+        auto err = std::strerror(errno);
+        ::close(sock);
+        return Error("Failed to listen on admin port {}: {}", port, err);
+    }
+
+    return std::unique_ptr<AdminServer>(new AdminServer(sock));
+}
+
+void AdminServer::publish(const Stats& stats) {
+    std::unique_lock lock(mutex, std::try_to_lock);
+    if (lock.owns_lock()) published = stats;
+}
+
+void AdminServer::Run(std::stop_token stop) {
+    while (not stop.stop_requested()) {
+        // Poll with a timeout so we notice when we’re asked to stop.
+        pollfd pfd{listener, POLLIN, 0};
+        if (::poll(&pfd, 1, 250) <= 0) continue;
+
+        int client = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client == -1) continue;
+        Serve(client);
+        ::close(client);
+    }
+}
+
+void AdminServer::Serve(int client) {
+    // Don’t let a misbehaving client hold us up for too long.
+    timeval timeout{.tv_sec = 1, .tv_usec = 0};
+    ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+    ::setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof timeout);
+
+    // We serve the same thing no matter what was requested, but read
+    // the request anyway since some clients get upset if we close the
+    // connexion before they’re done sending it.
+    std::string request;
+    char buf[1'024];
+    while (request.size() < 8'192 and not request.contains("\r\n\r\n")) {
+        auto n = ::recv(client, buf, sizeof buf, 0);
+        if (n <= 0) break;
+        request.append(buf, usz(n));
+    }
+
+    Stats stats;
+    {
+        std::unique_lock _(mutex);
+        stats = published;
+    }
+
+    auto body = Render(stats);
+    auto response = std::format(
+        "HTTP/1.0 200 OK\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: {}\r\n"
+        "Connection: close\r\n"
+        "\r\n"
+        "{}",
+        body.size(),
+        body
+    );
+
+    std::string_view data = response;
+    while (not data.empty()) {
+        auto n = ::send(client, data.data(), data.size(), MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n == -1 and errno == EINTR) continue;
+            return;
+        }
+        data.remove_prefix(usz(n));
+    }
+}
@@ -0,0 +1,193 @@
+#include <Server/EventLog.hh>
+
+#include <base/Base.hh>
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace pr;
+using namespace pr::server;
+
+namespace {
+/// How often to sync the current file to disk.
+constexpr chr::seconds SyncInterval = 5s;
+
+/// How often to start a new file.
+constexpr chr::hours RotationInterval = 1h;
+
+/// Maximum size of a single file before we start a new one.
+constexpr usz MaxFileSize = 64 * 1'024 * 1'024;
+} // namespace
+
+// =============================================================================
+//  Impl
+// =============================================================================
+struct EventLog::Impl {
+    LIBBASE_IMMOVABLE(Impl);
+
+    /// Directory that contains the event log files.
+    fs::Path directory;
+
+    /// Events recorded during the current tick; this is only
+    /// accessed by the server thread.
+    std::vector<std::byte> pending;
+
+    /// Events that are waiting to be written to disk.
+    std::vector<std::byte> queued;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stop = false;
+
+    /// The file we’re currently writing to. These are only
+    /// accessed by the writer thread.
+    int fd = -1;
+    usz file_size = 0;
+    chr::steady_clock::time_point opened;
+    chr::steady_clock::time_point last_sync;
+
+    /// The writer thread MUST be the last member.
+    std::jthread writer;
+
+    explicit Impl(fs::Path directory) : directory(std::move(directory)) {}
+    ~Impl();
+
+    void Close();
+    auto Rotate() -> Result<>;
+    void Run();
+    void Write(std::span<const std::byte> data);
+};
+
+EventLog::Impl::~Impl() {
+    {
+        std::unique_lock _(mutex);
+        stop = true;
+    }
+
+    cv.notify_one();
+    if (writer.joinable()) writer.join();
+    Close();
+}
+
+void EventLog::Impl::Close() {
+    if (fd == -1) return;
+    ::fdatasync(fd);
+    ::close(fd);
+    fd = -1;
+}
+
+auto EventLog::Impl::Rotate() -> Result<> {
+    Close();
+
+    // Name files after the time they were created so they sort
+    // chronologically; if we rotate more than once per second (or
+    // the server was restarted), add a sequence number to keep them
+    // apart. Never reopen an existing file since we’d end up with a
+    // second header in the middle of it.
+    auto now = chr::floor<chr::seconds>(chr::system_clock::now());
+    for (u32 seq = 0;; seq++) {
+        auto path = directory / std::format("events-{:%Y%m%d-%H%M%S}-{:03}.bin", now, seq);
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd != -1) break;
+        if (errno == EEXIST) continue;
+        return Error("Failed to open event log '{}': {}", path.string(), std::strerror(errno));
+    }
+
+    opened = last_sync = chr::steady_clock::now();
+    file_size = 0;
+    Write(std::as_bytes(std::span{events::Magic}));
+    Write(ser::Serialise<net::Endianness>(events::FileHeader{}));
+    return {};
+}
+
+void EventLog::Impl::Run() {
+    std::vector<std::byte> batch;
+    for (;;) {
+        {
+            std::unique_lock lock(mutex);
+            cv.wait_for(lock, SyncInterval, [&] { return stop or not queued.empty(); });
+            if (stop and queued.empty()) return;
+            std::swap(batch, queued);
+        }
+
+        // Start a new file if the current one is too large or too old.
+        auto now = chr::steady_clock::now();
+        if (fd == -1 or file_size >= MaxFileSize or now - opened >= RotationInterval) {
+            if (auto res = Rotate(); not res) {
+                Log<LogLevel::Error>("{}", res.error());
+                batch.clear();
+                continue;
+            }
+        }
+
+        Write(batch);
+        batch.clear();
+
+        // Syncing is expensive, so only do it every once in a while.
+        if (now - last_sync >= SyncInterval) {
+            ::fdatasync(fd);
+            last_sync = now;
+        }
+    }
+}
+
+void EventLog::Impl::Write(std::span<const std::byte> data) {
+    while (not data.empty()) {
+        auto written = ::write(fd, data.data(), data.size());
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            Log<LogLevel::Error>("Failed to write to event log: {}", std::strerror(errno));
+            return;
+        }
+
+        data = data.subspan(usz(written));
+        file_size += usz(written);
+    }
+}
+
+// =============================================================================
+//  API
+// =============================================================================
+EventLog::EventLog() = default;
+EventLog::EventLog(EventLog&&) noexcept = default;
+EventLog& EventLog::operator=(EventLog&&) noexcept = default;
+EventLog::~EventLog() = default;
+
+auto EventLog::Open(fs::PathRef directory) -> Result<EventLog> {
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec) return Error("Failed to create directory '{}': {}", directory.string(), ec.message());
+
+    EventLog log;
+    log.impl = std::make_unique<Impl>(directory);
+    Try(log.impl->Rotate());
+    log.impl->writer = std::jthread{[impl = log.impl.get()] { impl->Run(); }};
+    return log;
+}
+
+void EventLog::close() {
+    commit();
+    impl.reset();
+}
+
+void EventLog::Append(std::span<const std::byte> data) {
+    impl->pending.insert(impl->pending.end(), data.begin(), data.end());
+}
+
+void EventLog::commit() {
+    if (not impl or impl->pending.empty()) return;
+    {
+        std::unique_lock _(impl->mutex);
+        impl->queued.insert(impl->queued.end(), impl->pending.begin(), impl->pending.end());
+    }
+
+    impl->pending.clear();
+    impl->cv.notify_one();
+}
@@ -9,17 +9,64 @@ using namespace command_line_options;
 using options = clopts< // clang-format off
     option<"--port", "The port to listen on", i64>,
     option<"--pwd", "Password to the game">,
+    option<"--admin-port", "Serve server statistics on this port on localhost", i64>,
+    option<"--event-log", "Directory to write the binary event log to">,
+    option<"--log-level", "Minimum level of messages to log: trace, debug, info, warning, or error">,
+    flag<"--keep-running", "Start a new game once the current one is over instead of exiting">,
     help<>
 >; // clang-format on
 
 int main(int argc, char* argv[]) {
     auto opts = options::parse(argc, argv);
 
+    if (auto level = opts.get<"--log-level">()) {
+        auto parsed = ParseLogLevel(*level);
+        if (not parsed) {
+            std::println(stderr, "ERROR: {}", parsed.error());
+            return 1;
+        }
+
+        SetLogLevel(parsed.value());
+    }
+
     i64 port = opts.get_or<"--port">(net::DefaultPort);
     if (port <= 0 or port > std::numeric_limits<u16>::max()) {
         std::println(stderr, "ERROR: invalid port {}", port);
         return 1;
     }
 
-    server::Server(u16(port), opts.get_or<"--pwd">("")).Run();
+    server::EventLog event_log;
+    if (auto dir = opts.get<"--event-log">()) {
+        auto log = server::EventLog::Open(*dir);
+        if (not log) {
+            std::println(stderr, "ERROR: {}", log.error());
+            return 1;
+        }
+
+        event_log = std::move(log.value());
+    }
+
+    std::unique_ptr<server::AdminServer> admin;
+    if (auto admin_port = opts.get<"--admin-port">()) {
+        if (*admin_port <= 0 or *admin_port > std::numeric_limits<u16>::max()) {
+            std::println(stderr, "ERROR: invalid admin port {}", *admin_port);
+            return 1;
+        }
+
+        auto res = server::AdminServer::Create(u16(*admin_port));
+        if (not res) {
+            std::println(stderr, "ERROR: {}", res.error());
+            return 1;
+        }
+
+        admin = std::move(res.value());
+    }
+
+    server::Server(
+        u16(port),
+        opts.get_or<"--pwd">(""),
+        std::move(event_log),
+        std::move(admin),
+        opts.get<"--keep-running">()
+    ).Run();
 }
@@ -10,6 +10,7 @@
 #include <memory>
 #include <ranges>
 #include <thread>
+#include <utility>
 #include <vector>
 
 using namespace pr;
@@ -43,6 +44,16 @@ struct Server::Validator {
     bool stack_is_full(usz i) const { return p.word.stacks[i].full; }
 };
 
+bool IsGameAction(cs::ID id) {
+    switch (id) {
+#define X(name) case cs::ID::name:
+        CS_PLAY_PACKETS(X)
+#undef X
+        return true;
+        default: return false;
+    }
+}
+
 auto BuildWordArray(const Word& w) {
     return w.stacks | vws::transform(&Stack::get_top);
 }
@@ -79,7 +90,7 @@ void Player::set_connexion(net::TCPConnexion new_value) {
 //  Networking
 // =============================================================================
 void Server::Kick(net::TCPConnexion& client, DisconnectReason reason, std::source_location sloc) {
-    Log(
+    Log<LogLevel::Info, LogCategory::Net>(
         "Kicking client {} for reason {} (at {}:{}:{})",
         client.address,
         +reason,
@@ -88,11 +99,21 @@ void Server::Kick(net::TCPConnexion& client, DisconnectReason reason, std::sourc
         sloc.column()
     );
 
+    event_log.record(events::Kick{reason, std::string{client.address}});
     client.send(sc::Disconnect{reason});
     client.disconnect();
 }
 
 void Server::Tick() {
+    // If the game is over, get ready for the next one. Do this before
+    // receiving anything so a login can’t join the old game just before
+    // we throw its players away.
+    if (game_over) {
+        ResetGame();
+        for (auto& [conn, login] : std::exchange(deferred_logins, {}))
+            if (not conn.disconnected) handle(conn, std::move(login));
+    }
+
     // Receive incoming data.
     server.receive();
 
@@ -104,7 +125,7 @@ void Server::Tick() {
             // Don’t even bother sending a packet here; if they didn’t
             // respond within the time frame, they’re likely not actually
             // a game client, but rather some random other connexion.
-            Log("Client {} took too long to send a login packet", conn.address);
+            Log<LogLevel::Info, LogCategory::Net>("Client {} took too long to send a login packet", conn.address);
             conn.disconnect();
         }
     }
@@ -150,11 +171,13 @@ void Server::receive(net::TCPConnexion& client, net::ReceiveBuffer& buf) {
     // Limit how many packets we’re willing to process per tick per connexion.
     u32 count = 0;
     while (not client.disconnected and not buf.empty() and count++ < PacketsPerTick) {
+        auto id = buf.peek<cs::ID>().value();
+        auto start = chr::steady_clock::now();
         auto res = packets::HandleServerSidePacket(*this, client, buf);
 
         // If there was an error, close the connexion.
         if (not res) {
-            Log("Packet error while processing {}: {}", client.address, res.error());
+            Log<LogLevel::Warning, LogCategory::Net>("Packet error while processing {}: {}", client.address, res.error());
             return Kick(client, InvalidPacket);
         }
 
@@ -167,6 +190,19 @@ void Server::receive(net::TCPConnexion& client, net::ReceiveBuffer& buf) {
             // Stop processing packets until we have more data.
             return;
         }
+
+        stats.packets_received[+id]++;
+
+        // Record the action if it was applied, i.e. if the client
+        // didn’t get kicked for it; rejecting a play kicks the client
+        // but leaves the player attached, so check the connexion.
+        if (IsGameAction(id) and not client.disconnected) {
+            if (auto p = client.get<Player>()) {
+                auto duration = chr::duration_cast<chr::microseconds>(chr::steady_clock::now() - start);
+                event_log.record(events::Action{p->id, id, u32(duration.count())});
+                stats.record_action(duration);
+            }
+        }
     }
 }
 
@@ -174,7 +210,7 @@ void Server::receive(net::TCPConnexion& client, net::ReceiveBuffer& buf) {
 //  General Packet Handlers
 // =============================================================================
 void Server::handle(net::TCPConnexion& client, cs::Disconnect) {
-    Log("Client {} disconnected", client.address);
+    Log<LogLevel::Info, LogCategory::Net>("Client {} disconnected", client.address);
     client.disconnect();
 }
 
@@ -200,15 +236,22 @@ void Server::handle(net::TCPConnexion& client, sc::WordChoice wc) {
     // Word is valid. Mark it as submitted.
     for (auto [i, c] : wc.word | vws::enumerate) p->word.stacks[i].cards[0].id = c;
     p->submitted_word = true;
-    Log("Client gave back word");
+    Log<LogLevel::Debug, LogCategory::Game>("Client gave back word");
 }
 
 void Server::handle(net::TCPConnexion& client, cs::HeartbeatResponse res) {
-    Log("Received heartbeat response from client {}", res.seq_no);
+    Log<LogLevel::Trace, LogCategory::Net>("Received heartbeat response from client {}", res.seq_no);
 }
 
 void Server::handle(net::TCPConnexion& client, cs::Login login) {
-    Log("Login: name = {}, password = {}", login.name, login.password);
+    Log<LogLevel::Debug, LogCategory::Net>("Login: name = {}, password = {}", login.name, login.password);
+
+    // The game ended earlier during this tick; its players are about to
+    // be deleted, so wait until the next game has been set up.
+    if (game_over) {
+        deferred_logins.emplace_back(client, std::move(login));
+        return;
+    }
 
     // Mark this as no longer pending and also check whether it was
     // pending in the first place. Clients that are already connected
@@ -228,6 +271,7 @@ void Server::handle(net::TCPConnexion& client, cs::Login login) {
     // reach the player limit for the first time, so perform game
     // initialisation here if we have enough players.
     if (existing == players.end()) {
+        event_log.record(events::Login{false, login.name, std::string{client.address}});
         players.push_back(std::make_unique<Player>(std::move(client), std::move(login.name)));
         if (players.size() == PlayersNeeded) SetUpGame();
         return;
@@ -237,6 +281,7 @@ void Server::handle(net::TCPConnexion& client, cs::Login login) {
     // can’t connect to it again.
     auto& p = *existing;
     if (p.connected) return Kick(client, UsernameInUse);
+    event_log.record(events::Login{true, login.name, std::string{client.address}});
     p.connexion = std::move(client);
 
     // Get the player up to date with the current game state.
@@ -273,7 +318,7 @@ void Server::handle(net::TCPConnexion& client, cs::PlayNoTarget packet) {
     auto [p, card, _] = res;
     switch (card->id.value) {
         default:
-            Log("Sorry, playing {} is not implemented yet", CardDatabase[+card->id].name);
+            Log<LogLevel::Warning, LogCategory::Game>("Sorry, playing {} is not implemented yet", CardDatabase[+card->id].name);
             Kick(client, InvalidPacket);
             return;
 
@@ -323,7 +368,7 @@ void Server::handle(net::TCPConnexion& client, cs::PlayPlayerTarget packet) {
     auto [p, card, target_player] = res;
     switch (card->id.value) {
         default:
-            Log("Sorry, playing {} is not implemented yet", CardDatabase[+card->id].name);
+            Log<LogLevel::Warning, LogCategory::Game>("Sorry, playing {} is not implemented yet", CardDatabase[+card->id].name);
             Kick(client, InvalidPacket);
             return;
 
@@ -373,7 +418,7 @@ void Server::handle(net::TCPConnexion& client, cs::PlaySingleTarget packet) {
     // The card is a power card.
     switch (card->id.value) {
         default:
-            Log("Sorry, playing {} is not implemented yet", CardDatabase[+card->id].name);
+            Log<LogLevel::Warning, LogCategory::Game>("Sorry, playing {} is not implemented yet", CardDatabase[+card->id].name);
             Kick(client, InvalidPacket);
             return;
 
@@ -573,9 +618,20 @@ void Server::NextPlayer() {
         // If *all* players’ hands are empty, we need to end the game. This
         // *shouldn’t* happen, but you never know...
         if (rgs::all_of(players, [](auto& p) { return p.hand.empty(); })) {
-            Broadcast(sc::Disconnect{Unspecified});
-            Log("No more plays can be made. The game is a draw.");
-            std::exit(27);
+            Broadcast(sc::Disconnect{GameOver});
+            Log<LogLevel::Info, LogCategory::Game>("No more plays can be made. The game is a draw.");
+            if (not keep_running) {
+                // std::exit() doesn’t run our destructors.
+                event_log.close();
+                std::exit(27);
+            }
+
+            // Don’t process any more packets from these players; we can’t
+            // delete them just yet since we might be in the middle of handling
+            // a packet for one of them.
+            for (auto& p : players) p.disconnect();
+            game_over = true;
+            return;
         }
 
         NextPlayer();
@@ -589,6 +645,27 @@ bool Server::PromptNegation(Player& p, CardId power_card) {
     return true;
 }
 
+void Server::PublishStats(chr::microseconds tick_duration, const AllocationStats& tick_allocations) {
+    if (not admin) return;
+    stats.record_tick(tick_duration, tick_allocations);
+    stats.players = u32(players.size());
+    stats.connected_players = u32(rgs::count_if(players, &Player::get_connected));
+    stats.connexions = u32(server.connexions().size());
+    stats.pending_connexions = u32(pending_connexions.size());
+    stats.game_running = state == State::Running;
+    stats.send_queue_bytes = 0;
+    stats.max_send_queue_bytes = 0;
+    stats.buffer_capacity_bytes = 0;
+    for (auto& c : server.connexions()) {
+        u64 queued = c.send_queue_size;
+        stats.send_queue_bytes += queued;
+        stats.max_send_queue_bytes = std::max(stats.max_send_queue_bytes, queued);
+        stats.buffer_capacity_bytes += c.buffer_capacity;
+    }
+
+    admin->publish(stats);
+}
+
 void Server::RemoveCard(Player& p, Card& c, bool to_discard_pile, bool notify) {
     auto it = rgs::find_if(p.hand, [&](Card& x) { return &x == &c; });
     Assert(it != p.hand.end(), "Card not in hand");
@@ -597,6 +674,20 @@ void Server::RemoveCard(Player& p, Card& c, bool to_discard_pile, bool notify) {
     p.hand.erase(it);
 }
 
+void Server::ResetGame() {
+    Log<LogLevel::Info, LogCategory::Game>("Starting a new game");
+    game_over = false;
+    stats.games_completed++;
+
+    // The players’ connexions have already been closed, so
+    // just throw everything away.
+    players.clear();
+    deck.clear();
+    discard.clear();
+    current_player = 0;
+    state = State::WaitingForPlayerRegistration;
+}
+
 void Server::SendGameState(Player& p) {
     // Yes, we recompute this every time this packet is sent, but
     // it’s sent so rarely (once at the start of the game and once
@@ -684,7 +775,7 @@ void Server::SetUpGame() {
     // is connect, give that player the first turn.
     auto it = rgs::find_if(players, [](auto& p) { return p.name == "debugger" or p.name == "console"; });
     if (it != players.end()) {
-        Log("Debugger or console found.");
+        Log<LogLevel::Debug, LogCategory::Game>("Debugger or console found.");
         players.swap_iterators(it, players.begin());
     }
 #endif
@@ -696,28 +787,54 @@ void Server::SetUpGame() {
 // =============================================================================
 //  API
 // =============================================================================
-Server::Server(u16 port, std::string password)
-    : server(net::TCPServer::Create(port, 200).value()),
-      password(std::move(password)) {
+Server::Server(
+    u16 port,
+    std::string password,
+    EventLog event_log,
+    std::unique_ptr<AdminServer> admin,
+    bool keep_running
+) : server(net::TCPServer::Create(port, 200).value()),
+    password(std::move(password)),
+    keep_running(keep_running),
+    event_log(std::move(event_log)),
+    admin(std::move(admin)) {
     server.set_callbacks(*this);
+    this->event_log.record(events::RoomCreated{server.port(), u8(PlayersNeeded)});
 }
 
 void Server::Run() {
     constexpr chr::milliseconds ServerTickDuration = 33ms;
-    Log("Server listening on port {}", server.port());
+    Log<LogLevel::Info, LogCategory::Net>("Server listening on port {}", server.port());
     for (;;) {
         const auto start_of_tick = chr::system_clock::now();
+        AllocationScope allocations;
 
         Tick();
 
-        // Sleep for a bit.
+        // Record statistics.
+        const auto tick_allocations = allocations.delta();
         const auto end_of_tick = chr::system_clock::now();
+        const auto tick_duration_us = chr::duration_cast<chr::microseconds>(end_of_tick - start_of_tick);
+        event_log.record(events::Tick{u32(tick_duration_us.count()), u16(server.connexions().size())});
+        event_log.commit();
+        PublishStats(tick_duration_us, tick_allocations);
+
+        // Sleep for a bit.
         const auto tick_duration = chr::duration_cast<chr::milliseconds>(end_of_tick - start_of_tick);
         if (tick_duration < ServerTickDuration) {
             std::this_thread::sleep_for(ServerTickDuration - tick_duration);
         } else {
 #ifndef PRESCRIPTIVISM_ENABLE_SANITISERS
-            Log("Server tick took too long: {}ms", tick_duration.count());
+            if constexpr (AllocationTrackingEnabled) {
+                Log<LogLevel::Warning, LogCategory::Game>(
+                    "Server tick took too long: {}ms, {} allocations ({} bytes)",
+                    tick_duration.count(),
+                    tick_allocations.allocations,
+                    tick_allocations.bytes
+                );
+            } else {
+                Log<LogLevel::Warning, LogCategory::Game>("Server tick took too long: {}ms", tick_duration.count());
+            }
 #endif
         }
     }
@@ -0,0 +1,73 @@
+#include <Shared/Allocations.hh>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if PRESCRIPTIVISM_TRACK_ALLOCATIONS
+#    include <malloc.h>
+#endif
+
+using namespace pr;
+
+#if PRESCRIPTIVISM_TRACK_ALLOCATIONS
+// Thread-local so we don’t need any synchronisation and so we can
+// attribute allocations to the server tick or the client frame, both
+// of which run on the main thread.
+constinit thread_local AllocationStats ThreadStats;
+constinit std::atomic<u64> LiveBytes = 0;
+
+auto Allocate(usz n, usz align, bool nothrow) -> void* {
+    if (n == 0) n = 1;
+    void* ptr = align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__
+                  ? std::malloc(n)
+                  : std::aligned_alloc(align, (n + align - 1) & ~(align - 1));
+
+    if (not ptr) {
+        if (nothrow) return nullptr;
+        std::abort();
+    }
+
+    ThreadStats.allocations++;
+    ThreadStats.bytes += n;
+    LiveBytes.fetch_add(::malloc_usable_size(ptr), std::memory_order::relaxed);
+    return ptr;
+}
+
+void Deallocate(void* ptr) {
+    if (not ptr) return;
+    ThreadStats.deallocations++;
+    LiveBytes.fetch_sub(::malloc_usable_size(ptr), std::memory_order::relaxed);
+    std::free(ptr);
+}
+
+auto pr::ThreadAllocations() -> AllocationStats { return ThreadStats; }
+auto pr::LiveHeapBytes() -> u64 { return LiveBytes.load(std::memory_order::relaxed); }
+
+// clang-format off
+void* operator new(usz n) { return Allocate(n, 0, false); }
+void* operator new[](usz n) { return Allocate(n, 0, false); }
+void* operator new(usz n, const std::nothrow_t&) noexcept { return Allocate(n, 0, true); }
+void* operator new[](usz n, const std::nothrow_t&) noexcept { return Allocate(n, 0, true); }
+void* operator new(usz n, std::align_val_t a) { return Allocate(n, usz(a), false); }
+void* operator new[](usz n, std::align_val_t a) { return Allocate(n, usz(a), false); }
+void* operator new(usz n, std::align_val_t a, const std::nothrow_t&) noexcept { return Allocate(n, usz(a), true); }
+void* operator new[](usz n, std::align_val_t a, const std::nothrow_t&) noexcept { return Allocate(n, usz(a), true); }
+
+void operator delete(void* p) noexcept { Deallocate(p); }
+void operator delete[](void* p) noexcept { Deallocate(p); }
+void operator delete(void* p, usz) noexcept { Deallocate(p); }
+void operator delete[](void* p, usz) noexcept { Deallocate(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { Deallocate(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { Deallocate(p); }
+void operator delete(void* p, std::align_val_t) noexcept { Deallocate(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { Deallocate(p); }
+void operator delete(void* p, usz, std::align_val_t) noexcept { Deallocate(p); }
+void operator delete[](void* p, usz, std::align_val_t) noexcept { Deallocate(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { Deallocate(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { Deallocate(p); }
+// clang-format on
+#else
+auto pr::ThreadAllocations() -> AllocationStats { return {}; }
+auto pr::LiveHeapBytes() -> u64 { return 0; }
+#endif
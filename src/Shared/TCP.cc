@@ -84,6 +84,7 @@ struct AcceptedConnexion {
 auto AcceptConnexion(Socket sock, bool& done) -> std::optional<AcceptedConnexion>;
 auto ConnectToServer(const std::string& remote_address, u16 port) -> Result<SocketHolder>;
 auto CreateServerSocket(u16 port, u32 max_connexions) -> Result<SocketHolder>;
+auto CreateSocketPair() -> Result<std::pair<SocketHolder, SocketHolder>>;
 } // namespace pr::net::impl
 
 // =============================================================================
@@ -144,21 +145,21 @@ auto impl::AcceptConnexion(Socket sock, bool& done) -> std::optional<AcceptedCon
             return std::nullopt;
         }
 
-        Log("Failed to accept connexion: {}", std::strerror(errno));
+        Log<LogLevel::Warning, LogCategory::Net>("Failed to accept connexion: {}", std::strerror(errno));
         return std::nullopt;
     }
 
     // Make the connexion non-blocking.
     auto res = MakeNonBlocking(new_sock.handle());
     if (not res) {
-        Log("Failed to make connexion non-blocking: {}", res.error());
+        Log<LogLevel::Warning, LogCategory::Net>("Failed to make connexion non-blocking: {}", res.error());
         return std::nullopt;
     }
 
     // Get the IP address.
     char ip_str[INET_ADDRSTRLEN]{};
     if (inet_ntop(AF_INET, &sa.sin_addr, ip_str, sizeof ip_str) == nullptr) {
-        Log("Failed to get IP address: {}", std::strerror(errno));
+        Log<LogLevel::Warning, LogCategory::Net>("Failed to get IP address: {}", std::strerror(errno));
         return std::nullopt;
     }
 
@@ -207,7 +208,7 @@ auto impl::ConnectToServer(const std::string& remote_address, u16 port) -> Resul
             if (connect(sock.handle(), a->ai_addr, a->ai_addrlen) != -1) {
                 char buf[64]{};
                 inet_ntop(a->ai_family, a->ai_addr, buf, sizeof buf);
-                Log("Address {} resolved to {}", remote_address, std::string_view{buf});
+                Log<LogLevel::Debug, LogCategory::Net>("Address {} resolved to {}", remote_address, std::string_view{buf});
                 return true;
             }
         }
@@ -250,6 +251,16 @@ auto impl::CreateServerSocket(u16 port, u32 max_connexions) -> Result<SocketHold
     // Take care to clear 'fd' so we don't close the socket.
     return std::move(sock);
 }
+
+auto impl::CreateSocketPair() -> Result<std::pair<SocketHolder, SocketHolder>> {
+    Socket fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == -1) return Error(
+        "Failed to create socket pair: {}",
+        std::strerror(errno)
+    );
+
+    return std::pair{SocketHolder{fds[0]}, SocketHolder{fds[1]}};
+}
 #endif
 
 // =============================================================================
@@ -293,6 +304,7 @@ struct TCPServer::Impl : impl::SocketHolder {
         : SocketHolder(std::move(socket)),
           port(port) {}
 
+    void AddConnexion(TCPConnexion conn);
     void CloseConnexionAfterError(TCPConnexion& conn);
     void UpdateConnexions();
     void ReceiveAll();
@@ -354,7 +366,7 @@ void TCPConnexion::Impl::Receive(std::function<void(ReceiveBuffer&)> callback) {
 
     // If we receive 0, the connexion was closed.
     if (sz == 0) {
-        Log("Connexion {} closed by peer", ip_address);
+        Log<LogLevel::Info, LogCategory::Net>("Connexion {} closed by peer", ip_address);
         return Disconnect();
     }
 
@@ -380,7 +392,7 @@ usz TCPConnexion::Impl::SendImpl(std::span<const std::byte> data) {
         if (errno == EINTR) return SendImpl(data);
         if (errno == EWOULDBLOCK or errno == EAGAIN) return 0;
         if (errno == ECONNRESET or errno == EPIPE) return Disconnect(), 0;
-        Log("Unexpected error while sending data to {}: {}", ip_address, std::strerror(errno));
+        Log<LogLevel::Error, LogCategory::Net>("Unexpected error while sending data to {}: {}", ip_address, std::strerror(errno));
         return Disconnect(), 0;
     }
 
@@ -390,9 +402,16 @@ usz TCPConnexion::Impl::SendImpl(std::span<const std::byte> data) {
 // =============================================================================
 //  Impl - Server
 // =============================================================================
+void TCPServer::Impl::AddConnexion(TCPConnexion conn) {
+    if (tcp_callbacks->accept(conn)) {
+        Log<LogLevel::Info, LogCategory::Net>("Added connexion from {}", conn.address);
+        all_connexions.push_back(std::move(conn));
+    }
+}
+
 void TCPServer::Impl::CloseConnexionAfterError(TCPConnexion& conn) {
-    if (errno == ECONNRESET) Log("Connexion {} reset by client", conn.address);
-    else Log("Error while processing connexion {}: {}", conn.address, std::strerror(errno));
+    if (errno == ECONNRESET) Log<LogLevel::Info, LogCategory::Net>("Connexion {} reset by client", conn.address);
+    else Log<LogLevel::Warning, LogCategory::Net>("Error while processing connexion {}: {}", conn.address, std::strerror(errno));
     conn.disconnect();
 }
 
@@ -419,18 +438,14 @@ void TCPServer::Impl::UpdateConnexions() {
         auto conn = impl::AcceptConnexion(handle(), done);
         if (not conn) continue;
 
-        // Create the connexion.
+        // Create the connexion and try to accept it.
         TCPConnexion c;
         c.impl = std::make_shared<TCPConnexion::Impl>(
             std::move(conn->socket),
             std::move(conn->ip_address)
         );
 
-        // Try to accept it.
-        if (tcp_callbacks->accept(c)) {
-            Log("Added connexion from {}", c.address);
-            all_connexions.push_back(std::move(c));
-        }
+        AddConnexion(std::move(c));
     }
 }
 
@@ -450,6 +465,14 @@ auto TCPConnexion::Connect(
     return conn;
 }
 
+auto TCPConnexion::Loopback() -> Result<std::pair<TCPConnexion, TCPConnexion>> {
+    auto [a, b] = Try(impl::CreateSocketPair());
+    std::pair<TCPConnexion, TCPConnexion> conns;
+    conns.first.impl = std::make_shared<Impl>(std::move(a), "loopback");
+    conns.second.impl = std::make_shared<Impl>(std::move(b), "loopback");
+    return conns;
+}
+
 auto TCPServer::Create(u16 port, u32 max_connexions) -> Result<TCPServer> {
     TCPServer server;
     auto sock = Try(impl::CreateServerSocket(port, max_connexions));
@@ -471,10 +494,20 @@ auto TCPConnexion::get_address() const -> std::string_view {
     return impl->ip_address;
 }
 
+auto TCPConnexion::get_buffer_capacity() const -> usz {
+    if (disconnected) return 0;
+    return impl->send_buffer.capacity() + impl->receive_buffer.capacity();
+}
+
 bool TCPConnexion::get_disconnected() const {
     return not impl or impl->disconnected;
 }
 
+auto TCPConnexion::get_send_queue_size() const -> usz {
+    if (disconnected) return 0;
+    return impl->send_buffer.size();
+}
+
 void TCPConnexion::receive(std::function<void(ReceiveBuffer&)> callback) {
     if (not disconnected) return impl->Receive(callback);
 }
@@ -487,6 +520,11 @@ void TCPConnexion::set(void* data) {
     if (not disconnected) impl->user_data = data;
 }
 
+void TCPServer::add_connexion(TCPConnexion connexion) {
+    Assert(impl->tcp_callbacks, "Callbacks not set");
+    impl->AddConnexion(std::move(connexion));
+}
+
 auto TCPServer::connexions() -> std::span<TCPConnexion> { return impl->all_connexions; }
 auto TCPServer::port() const -> u16 { return impl->port; }
 void TCPServer::receive() { impl->ReceiveAll(); }
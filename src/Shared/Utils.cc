@@ -1,10 +1,10 @@
 #include <Shared/Utils.hh>
 
+#include <atomic>
 #include <chrono>
-#include <condition_variable>
-#include <mutex>
+#include <cstdlib>
+#include <cstring>
 #include <print>
-#include <queue>
 #include <thread>
 
 using namespace pr;
@@ -20,53 +20,195 @@ extern "C" const char* __asan_default_options() {
 // Run the logger on a separate thread since printing to the console
 // might be slow depending on what console we’re printing to (it can
 // take ~100ms in my IDE).
-std::mutex LoggerMutex;
-std::condition_variable LoggerCV;
-std::queue<std::pair<chr::system_clock::time_point, std::string>> LoggerQueue;
-std::once_flag LoggerInitialised;
-std::atomic_bool Enabled = true;
-std::jthread LoggerThread([](std::stop_token tok) {
+//
+// Log records are kept in a fixed-size ring buffer, to which any thread
+// can append without taking a lock. Each producer claims a ticket by
+// incrementing the write position; the ticket determines the slot and
+// the ‘lap’, i.e. how many times the ring has wrapped around. A slot’s
+// sequence number encodes its state for the current lap:
+//
+//   2 * lap     - Free; the producer holding the ticket may write to it.
+//   2 * lap + 1 - Published; the logger thread may read it.
+//
+// Once the logger thread is done with a slot, it sets the sequence
+// number to that of the next lap, which frees it for the next producer;
+// this scheme means that a zero-initialised ring is in a valid state.
+//
+// A producer only takes a ticket once it has seen that the slot for it
+// is free, so it never has to wait for the logger thread; if the ring is
+// full, the message is dropped instead, and the logger thread reports
+// how many messages were lost the next time it gets to print something.
+// The only exception is the shutdown sentinel, which must not be lost.
+constexpr usz LogRingSize = 1024;
+constinit detail::LogRecord LogRing[LogRingSize]{};
+constinit std::atomic<u64> LogWritePos = 0;
+constinit std::atomic<u64> LogDropped = 0;
+constinit std::atomic_bool LoggerStopped = false;
+constinit std::atomic<LogLevel> detail::LogThresholds[LogCategoryCount]{};
+constinit std::atomic_bool detail::LogEnabled = true;
+
+constexpr auto Lap(u64 ticket) -> u64 {
+    return ticket / LogRingSize * 2;
+}
+
+auto TryClaimRecord() -> detail::LogRecord* {
+    auto ticket = LogWritePos.load(std::memory_order::relaxed);
+    for (;;) {
+        auto& rec = LogRing[ticket % LogRingSize];
+        auto seq = rec.sequence.load(std::memory_order::acquire);
+
+        // The slot is free for this lap; try to take the ticket. If
+        // someone else got there first, this reloads the ticket.
+        if (seq == Lap(ticket)) {
+            if (LogWritePos.compare_exchange_weak(ticket, ticket + 1, std::memory_order::relaxed)) {
+                rec.ticket = ticket;
+                return &rec;
+            }
+        }
+
+        // The slot still belongs to the previous lap, so the ring is full.
+        else if (seq < Lap(ticket)) {
+            return nullptr;
+        }
+
+        // Another producer has already taken and published this ticket.
+        else {
+            ticket = LogWritePos.load(std::memory_order::relaxed);
+        }
+    }
+}
+
+void PrintDropped() {
+    auto dropped = LogDropped.exchange(0, std::memory_order::relaxed);
+    if (dropped == 0) return;
+    std::print(stderr, "\033[35mWarning:\033[m Log buffer full; dropped {} message{}\n", dropped, dropped == 1 ? "" : "s");
+}
+
+void PrintRecord(detail::LogRecord& rec, std::string& msg) {
+    msg.clear();
+    if (rec.kind == detail::LogRecord::Kind::Deferred) rec.format(msg, rec.fmt, rec.buffer);
+    else msg.append(reinterpret_cast<const char*>(rec.buffer), rec.size);
+    if (not msg.ends_with('\n')) msg += '\n';
+
+    std::string_view tag = [&] {
+        switch (rec.level) {
+            case LogLevel::Trace:
+            case LogLevel::Debug:
+            case LogLevel::Info: return ""sv;
+            case LogLevel::Warning: return "\033[35mWarning:\033[m "sv;
+            case LogLevel::Error: return "\033[31mError:\033[m "sv;
+        }
+        Unreachable();
+    }();
+
+    std::string_view category = [&] {
+        switch (rec.category) {
+            case LogCategory::General: return ""sv;
+            case LogCategory::Net: return "[net] "sv;
+            case LogCategory::Game: return "[game] "sv;
+            case LogCategory::Render: return "[render] "sv;
+            case LogCategory::UI: return "[ui] "sv;
+        }
+        Unreachable();
+    }();
+
+    std::tm now_tm;
+    std::time_t now_c = chr::system_clock::to_time_t(rec.time);
+    ::localtime_r(&now_c, &now_tm);
+    std::print(
+        stderr,
+        "\033[33m[{:02}:{:02}:{:02}]\033[m {}{}{}",
+        now_tm.tm_hour,
+        now_tm.tm_min,
+        now_tm.tm_sec,
+        category,
+        tag,
+        msg
+    );
+}
+
+std::jthread LoggerThread([] {
+    // Enqueue a sentinel on exit; since records are processed in order,
+    // this also makes sure that everything logged before it is printed.
     std::atexit([] {
-        LoggerThread.request_stop();
-        LoggerQueue.emplace();
-        LoggerCV.notify_one();
+        LoggerStopped.store(true, std::memory_order::relaxed);
+        auto rec = TryClaimRecord();
+        while (not rec) {
+            std::this_thread::yield();
+            rec = TryClaimRecord();
+        }
+
+        rec->kind = detail::LogRecord::Kind::Stop;
+        detail::LogPublish(*rec);
     });
 
-    for (;;) {
-        std::unique_lock lock(LoggerMutex);
-        LoggerCV.wait(lock, [&] { return not LoggerQueue.empty(); });
-        if (tok.stop_requested()) return;
-        auto [time, msg] = std::move(LoggerQueue.front());
-        LoggerQueue.pop();
-        lock.unlock();
-        if (not Enabled) continue;
-
-        std::tm now_tm;
-        std::time_t now_c = chr::system_clock::to_time_t(time);
-        ::localtime_r(&now_c, &now_tm);
-        std::print(
-            stderr,
-            "\033[33m[{:02}:{:02}:{:02}]\033[m {}",
-            now_tm.tm_hour,
-            now_tm.tm_min,
-            now_tm.tm_sec,
-            msg
-        );
+    std::string msg;
+    for (u64 ticket = 0;; ticket++) {
+        auto& rec = LogRing[ticket % LogRingSize];
+        for (;;) {
+            auto seq = rec.sequence.load(std::memory_order::acquire);
+            if (seq == Lap(ticket) + 1) break;
+            rec.sequence.wait(seq, std::memory_order::relaxed);
+        }
+
+        PrintDropped();
+        if (rec.kind == detail::LogRecord::Kind::Stop) return;
+        PrintRecord(rec, msg);
+
+        // Hand the slot to whoever is going to use it next.
+        rec.sequence.store(Lap(ticket) + 2, std::memory_order::release);
+        rec.sequence.notify_all();
     }
 });
 
-void pr::LogImpl(std::string msg) {
-    if (not msg.ends_with('\n')) msg += '\n';
-    chr::system_clock::time_point now = chr::system_clock::now();
-    std::unique_lock _(LoggerMutex);
-    LoggerQueue.emplace(now, std::move(msg));
-    LoggerCV.notify_one();
+auto detail::LogAcquire() -> LogRecord* {
+    if (LoggerStopped.load(std::memory_order::relaxed)) return nullptr;
+    auto rec = TryClaimRecord();
+    if (not rec) LogDropped.fetch_add(1, std::memory_order::relaxed);
+    return rec;
+}
+
+void detail::LogPublish(LogRecord& rec) {
+    rec.sequence.store(Lap(rec.ticket) + 1, std::memory_order::release);
+
+    // This is cheap if no-one is waiting, i.e. if the logger thread
+    // is busy anyway; it only wakes it up if it’s idle.
+    rec.sequence.notify_all();
+}
+
+void detail::LogMarkTruncated(LogRecord& rec) {
+    static constexpr std::string_view Ellipsis = "…";
+
+    // Back up to the start of a code point so we don’t leave
+    // half a UTF-8 sequence in front of the ellipsis.
+    auto text = reinterpret_cast<char*>(rec.buffer);
+    usz end = rec.BufferSize - Ellipsis.size();
+    while (end != 0 and (u8(text[end]) & 0xC0) == 0x80) end--;
+    std::memcpy(text + end, Ellipsis.data(), Ellipsis.size());
+    rec.size = u32(end + Ellipsis.size());
+}
+
+void pr::SetLogLevel(LogLevel level) {
+    for (auto& t : detail::LogThresholds) t.store(level, std::memory_order::relaxed);
+}
+
+void pr::SetLogLevel(LogCategory category, LogLevel level) {
+    detail::LogThresholds[std::to_underlying(category)].store(level, std::memory_order::relaxed);
+}
+
+auto pr::ParseLogLevel(std::string_view name) -> Result<LogLevel> {
+    if (name == "trace") return LogLevel::Trace;
+    if (name == "debug") return LogLevel::Debug;
+    if (name == "info") return LogLevel::Info;
+    if (name == "warning") return LogLevel::Warning;
+    if (name == "error") return LogLevel::Error;
+    return Error("Unknown log level '{}'; expected one of: trace, debug, info, warning, error", name);
 }
 
 SilenceLog::SilenceLog() {
-    Enabled = false;
+    detail::LogEnabled.store(false, std::memory_order::relaxed);
 }
 
 SilenceLog::~SilenceLog() {
-    Enabled = true;
+    detail::LogEnabled.store(true, std::memory_order::relaxed);
 }
@@ -29,6 +29,15 @@ int main(int argc, char** argv) {
     signal(SIGPIPE, SIG_IGN);
     signal(SIGCHLD, SIG_IGN);
 
+    // Load test mode: run headless bots instead of the GUI clients; any
+    // other arguments are passed on to the load tester.
+    if (argc >= 2 and std::string_view{argv[1]} == "-l") {
+        std::system("cmake --build out -- PrescriptivismServer loadtest");
+        argv[1] = const_cast<char*>("loadtest");
+        execv("./loadtest", argv + 1);
+        abort();
+    }
+
     // Do not rebuild ourselves as that may cause a crash.
     std::system("cmake --build out -- PrescriptivismServer Prescriptivism");
 
@@ -0,0 +1,185 @@
+#include <Server/EventLog.hh>
+
+#include <base/Base.hh>
+
+#include <cstring>
+#include <print>
+#include <string>
+#include <vector>
+
+using namespace pr;
+using namespace pr::server;
+using DisconnectReason = packets::common::Disconnect::Reason;
+
+struct Row {
+    std::string_view event{};
+    std::string port{};
+    std::string max_players{};
+    std::string reconnect{};
+    std::string name{};
+    std::string address{};
+    std::string player{};
+    std::string packet{};
+    std::string reason{};
+    std::string duration{};
+    std::string connexions{};
+};
+
+auto Quote(std::string_view s) -> std::string {
+    if (not s.contains(',') and not s.contains('"') and not s.contains('\n')) return std::string{s};
+    std::string quoted{"\""};
+    for (auto c : s) {
+        if (c == '"') quoted += '"';
+        quoted += c;
+    }
+    quoted += '"';
+    return quoted;
+}
+
+auto PacketName(packets::cs::ID id) -> std::string {
+    switch (id) {
+#define X(name) \
+    case packets::cs::ID::name: return #name;
+        CS_PACKETS(X)
+#undef X
+    }
+    return std::format("{}", +id);
+}
+
+auto ReasonName(DisconnectReason r) -> std::string {
+    switch (r) {
+        case DisconnectReason::Unspecified: return "Unspecified";
+        case DisconnectReason::InvalidPacket: return "InvalidPacket";
+        case DisconnectReason::ServerFull: return "ServerFull";
+        case DisconnectReason::UsernameInUse: return "UsernameInUse";
+        case DisconnectReason::WrongPassword: return "WrongPassword";
+        case DisconnectReason::UnexpectedPacket: return "UnexpectedPacket";
+        case DisconnectReason::PacketTooLarge: return "PacketTooLarge";
+        case DisconnectReason::BufferFull: return "BufferFull";
+        case DisconnectReason::GameOver: return "GameOver";
+    }
+    return std::format("{}", +r);
+}
+
+template <typename T>
+auto Read(net::ReceiveBuffer& buf) -> Result<T> {
+    auto ev = buf.read<T>();
+    if (not ev) return Error("Truncated record");
+    return std::move(ev.value());
+}
+
+auto ReadRow(net::ReceiveBuffer& buf, events::Type type) -> Result<Row> {
+    switch (type) {
+        case events::Type::RoomCreated: {
+            auto ev = Try(Read<events::RoomCreated>(buf));
+            return Row{
+                .event = "RoomCreated",
+                .port = std::to_string(ev.port),
+                .max_players = std::to_string(ev.max_players),
+            };
+        }
+
+        case events::Type::Login: {
+            auto ev = Try(Read<events::Login>(buf));
+            return Row{
+                .event = "Login",
+                .reconnect = ev.reconnect ? "1" : "0",
+                .name = Quote(ev.name),
+                .address = Quote(ev.address),
+            };
+        }
+
+        case events::Type::Action: {
+            auto ev = Try(Read<events::Action>(buf));
+            return Row{
+                .event = "Action",
+                .player = std::to_string(ev.player),
+                .packet = PacketName(ev.packet),
+                .duration = std::to_string(ev.duration),
+            };
+        }
+
+        case events::Type::Kick: {
+            auto ev = Try(Read<events::Kick>(buf));
+            return Row{
+                .event = "Kick",
+                .address = Quote(ev.address),
+                .reason = ReasonName(ev.reason),
+            };
+        }
+
+        case events::Type::Tick: {
+            auto ev = Try(Read<events::Tick>(buf));
+            return Row{
+                .event = "Tick",
+                .duration = std::to_string(ev.duration),
+                .connexions = std::to_string(ev.connexions),
+            };
+        }
+    }
+
+    return Error("Unknown event type {}", +type);
+}
+
+auto Convert(std::string_view path) -> Result<> {
+    auto file = Try(File::Read(path));
+    std::vector<std::byte> bytes(file.size());
+    std::memcpy(bytes.data(), file.data<u8>(), file.size());
+    net::ReceiveBuffer buf{bytes};
+
+    auto magic = buf.read(events::Magic.size());
+    if (magic.size() != events::Magic.size() or std::memcmp(magic.data(), events::Magic.data(), magic.size()) != 0)
+        return Error("'{}' is not an event log", path);
+
+    auto header = buf.read<events::FileHeader>();
+    if (not header) return Error("'{}': Truncated file header", path);
+    if (header->version != events::Version) return Error(
+        "'{}' has version {}, but only version {} is supported",
+        path,
+        header->version,
+        events::Version
+    );
+
+    while (not buf.empty()) {
+        auto rec = buf.read<events::RecordHeader>();
+        if (not rec) return Error("'{}': Truncated record", path);
+        auto row = ReadRow(buf, rec->type);
+        if (not row) return Error("'{}': {}", path, row.error());
+
+        auto& r = row.value();
+        auto time = chr::sys_time<chr::microseconds>{chr::microseconds(i64(rec->timestamp))};
+        std::println(
+            "{:%FT%T}Z,{},{},{},{},{},{},{},{},{},{},{}",
+            time,
+            r.event,
+            r.port,
+            r.max_players,
+            r.reconnect,
+            r.name,
+            r.address,
+            r.player,
+            r.packet,
+            r.reason,
+            r.duration,
+            r.connexions
+        );
+    }
+
+    return {};
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::println(stderr, "Usage: {} <event log>...", argv[0]);
+        std::println(stderr, "Converts server event logs to CSV and prints them to stdout.");
+        return 1;
+    }
+
+    std::println("time,event,port,max_players,reconnect,name,address,player,packet,reason,duration_us,connexions");
+    for (int i = 1; i < argc; i++) {
+        if (auto res = Convert(argv[i]); not res) {
+            std::println(stderr, "Error: {}", res.error());
+            return 1;
+        }
+    }
+}
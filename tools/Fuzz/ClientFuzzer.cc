@@ -0,0 +1,77 @@
+#include "FuzzStats.hh"
+
+#include <Headless/Game.hh>
+
+#include <Shared/Packets.hh>
+#include <Shared/TCP.hh>
+#include <Shared/Utils.hh>
+
+#include <base/Base.hh>
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+using namespace pr;
+
+namespace {
+fuzz::Stats Stats;
+
+/// Plays along with whatever the server tells us so that we get as
+/// far into the game logic as possible.
+struct Observer : headless::GameObserver {
+    headless::Game* game = nullptr;
+
+    void on_word_choice(const constants::Word& word) override {
+        game->choose_word(word);
+    }
+
+    void on_start_turn() override {
+        auto moves = game->legal_moves();
+        if (not moves.empty()) game->play(moves.front());
+    }
+
+    void on_card_choice(const packets::CardChoiceChallenge&) override {
+        game->answer_card_choice({});
+    }
+
+    void on_prompt_negation(CardId) override {
+        game->answer_negation(false);
+    }
+};
+} // namespace
+
+extern "C" int LLVMFuzzerInitialize(int*, char***) {
+    SetLogLevel(LogLevel::Error);
+    return 0;
+}
+
+/// Feed data from the ‘server’ into the headless client model.
+///
+/// The first byte determines how large the chunks are that we hand
+/// to the client, just like a TCP connexion would split them up, so
+/// we also exercise packets that are split across several reads.
+extern "C" int LLVMFuzzerTestOneInput(const u8* data, usz size) {
+    fuzz::Stats::Input _{Stats, size};
+    if (size == 0) return 0;
+
+    Observer observer;
+    headless::Game game{[](std::span<const std::byte>) {}, &observer};
+    observer.game = &game;
+
+    auto chunk_size = usz(data[0]) + 1;
+    auto bytes = std::as_bytes(std::span{data + 1, size - 1});
+    std::vector<std::byte> buffer;
+    while (not bytes.empty() and game.phase != headless::Game::Phase::Disconnected) {
+        auto chunk = bytes.first(std::min(chunk_size, bytes.size()));
+        bytes = bytes.subspan(chunk.size());
+        buffer.insert(buffer.end(), chunk.begin(), chunk.end());
+
+        // Discard whatever the client processed, as TCPConnexion does.
+        net::ReceiveBuffer buf{buffer};
+        if (not game.receive(buf)) break;
+        buffer.erase(buffer.begin(), buffer.begin() + isz(buffer.size() - buf.size()));
+    }
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+#ifndef PRESCRIPTIVISM_TOOLS_FUZZ_FUZZSTATS_HH
+#define PRESCRIPTIVISM_TOOLS_FUZZ_FUZZSTATS_HH
+
+#include <Shared/Utils.hh>
+
+#include <base/Base.hh>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <print>
+
+#include <sanitizer/allocator_interface.h>
+
+namespace pr::fuzz {
+/// If a single input makes us allocate more than this, something is
+/// very wrong; none of the inputs we get are anywhere near this large.
+constexpr u64 MaxBytesPerInput = 64 << 20;
+
+/// How often to print statistics.
+constexpr chr::seconds ReportInterval = 10s;
+
+/// Statistics about the inputs we’ve run.
+///
+/// libFuzzer already reports exec/s, but only for the process as a
+/// whole; this keeps track of how much memory each input needs at
+/// most, which is where decoders that trust length prefixes or keep
+/// growing a buffer show up.
+class Stats {
+    using Clock = chr::steady_clock;
+
+    /// Bytes currently allocated, and the most we’ve seen during the
+    /// current input. These are signed since we also see frees of memory
+    /// that was allocated before we installed the hooks (or on another
+    /// thread).
+    ///
+    /// The hooks run on every thread, including the logger thread, so
+    /// these are per-thread; only the fuzzing thread’s counters are ever
+    /// read, which means we only count what the input itself allocates.
+    static inline constinit thread_local i64 live_bytes = 0;
+    static inline constinit thread_local i64 peak_bytes = 0;
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point last_report = start;
+    u64 execs = 0;
+
+    /// The input that needed the most memory.
+    u64 max_bytes = 0;
+    usz max_bytes_input_size = 0;
+
+public:
+    /// Tracks the memory used while running a single input.
+    class Input {
+        LIBBASE_IMMOVABLE(Input);
+        Stats& stats;
+        usz size;
+        i64 baseline = live_bytes;
+
+    public:
+        Input(Stats& stats, usz size) : stats(stats), size(size) { peak_bytes = live_bytes; }
+        ~Input() { stats.record(size, u64(std::max<i64>(0, peak_bytes - baseline))); }
+    };
+
+    Stats() {
+        __sanitizer_install_malloc_and_free_hooks(
+            [](const volatile void*, usz n) {
+                live_bytes += i64(n);
+                if (live_bytes > peak_bytes) peak_bytes = live_bytes;
+            },
+            [](const volatile void* ptr) {
+                live_bytes -= i64(__sanitizer_get_allocated_size(const_cast<const void*>(ptr)));
+            }
+        );
+    }
+
+    ~Stats() { report(); }
+
+    void record(usz input_size, u64 bytes) {
+        execs++;
+        if (bytes > max_bytes) {
+            max_bytes = bytes;
+            max_bytes_input_size = input_size;
+        }
+
+        // Crash so libFuzzer saves the input.
+        if (bytes > MaxBytesPerInput) {
+            std::println(stderr, "ERROR: Input of {} bytes allocated {} bytes at once", input_size, bytes);
+            std::abort();
+        }
+
+        if (auto now = Clock::now(); now - last_report >= ReportInterval) {
+            last_report = now;
+            report();
+        }
+    }
+
+    void report() const {
+        auto secs = chr::duration<f64>(Clock::now() - start).count();
+        std::println(
+            stderr,
+            "#stats execs: {} ({:.0f}/s), max memory per input: {} bytes (input size {})",
+            execs,
+            secs > 0 ? f64(execs) / secs : 0.0,
+            max_bytes,
+            max_bytes_input_size
+        );
+    }
+};
+} // namespace pr::fuzz
+
+#endif // PRESCRIPTIVISM_TOOLS_FUZZ_FUZZSTATS_HH
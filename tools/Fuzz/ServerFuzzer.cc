@@ -0,0 +1,120 @@
+#include "FuzzStats.hh"
+
+#include <Headless/Game.hh>
+#include <Server/Server.hh>
+
+#include <Shared/Constants.hh>
+#include <Shared/Packets.hh>
+#include <Shared/TCP.hh>
+#include <Shared/Utils.hh>
+
+#include <base/Base.hh>
+
+#include <algorithm>
+#include <format>
+#include <memory>
+#include <span>
+#include <vector>
+
+using namespace pr;
+
+namespace {
+fuzz::Stats Stats;
+
+/// Number of extra ticks to run at the end so the server gets
+/// to process anything that’s still in flight.
+constexpr usz DrainTicks = 2;
+
+/// A client connected to the server over a loopback connexion.
+///
+/// Getting a game going requires logging in and echoing back the word
+/// the server deals us, which the fuzzer would take a long time to figure
+/// out by itself, so a client can optionally do this for it. Everything
+/// the fuzzer sends is written to the connexion as-is.
+class Client : headless::GameObserver {
+    LIBBASE_IMMOVABLE(Client);
+
+    net::TCPConnexion conn;
+    headless::Game game;
+    bool choose_word;
+
+    /// Set once we can no longer make sense of what the server is sending.
+    bool lost_track = false;
+
+public:
+    Client(net::TCPConnexion conn, bool choose_word)
+        : conn(std::move(conn)),
+          game([this](std::span<const std::byte> data) { this->conn.send(data); }, this),
+          choose_word(choose_word) {}
+
+    void login(std::string name) { game.login(std::move(name), "password"); }
+    void send(std::span<const std::byte> data) { conn.send(data); }
+
+    /// Process whatever the server sent us.
+    void tick() {
+        conn.receive([&](net::ReceiveBuffer& buf) {
+            if (not lost_track and game.receive(buf)) return;
+
+            // Once we’ve injected garbage, the server may well disconnect
+            // us, or we might not understand it anymore; just drop the data.
+            lost_track = true;
+            auto discarded = buf.read(buf.size());
+            static_cast<void>(discarded);
+        });
+    }
+
+    void on_word_choice(const constants::Word& word) override {
+        if (choose_word) game.choose_word(word);
+    }
+};
+} // namespace
+
+extern "C" int LLVMFuzzerInitialize(int*, char***) {
+    SetLogLevel(LogLevel::Error);
+    return 0;
+}
+
+/// Feed data from ‘clients’ into a real server.
+///
+/// The first byte is a set of flags: if bit 0 is set, the clients log
+/// in by themselves; if bit 1 is set, they also submit the word they’re
+/// dealt, which starts the game. The rest of the input is a sequence of
+/// records, each of which is a header byte followed by up to 128 bytes of
+/// data; the header selects the client that sends the data and how long
+/// it is. The server runs a tick after every record.
+extern "C" int LLVMFuzzerTestOneInput(const u8* data, usz size) {
+    fuzz::Stats::Input _{Stats, size};
+    if (size == 0) return 0;
+
+    // Keep the server running after a game so it doesn’t exit on us,
+    // and seed it so crashes are reproducible.
+    server::Server s{0, "password", {}, {}, true};
+    s.Seed(0);
+
+    auto flags = data[0];
+    std::vector<std::unique_ptr<Client>> clients;
+    for (usz i = 0; i < constants::PlayersPerGame; i++) {
+        auto [ours, theirs] = net::TCPConnexion::Loopback().value();
+        s.AddConnexion(std::move(theirs));
+        auto& c = clients.emplace_back(std::make_unique<Client>(std::move(ours), flags & 2));
+        if (flags & 1) c->login(std::format("fuzz{}", i));
+    }
+
+    auto Tick = [&] {
+        s.Tick();
+        for (auto& c : clients) c->tick();
+    };
+
+    Tick();
+    auto bytes = std::as_bytes(std::span{data + 1, size - 1});
+    while (not bytes.empty()) {
+        auto header = u8(bytes.front());
+        auto len = std::min(usz(header >> 1) + 1, bytes.size() - 1);
+        clients[header % clients.size()]->send(bytes.subspan(1, len));
+        bytes = bytes.subspan(1 + len);
+        Tick();
+    }
+
+    for (usz i = 0; i < DrainTicks; i++) Tick();
+    return 0;
+}
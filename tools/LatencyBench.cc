@@ -0,0 +1,286 @@
+#include <Headless/Game.hh>
+
+#include <Shared/Constants.hh>
+#include <Shared/Packets.hh>
+#include <Shared/Utils.hh>
+
+#include <base/Base.hh>
+
+#include <clopts.hh>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <print>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef __linux__
+#    error TODO: Non-linux support
+#endif
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace pr;
+using namespace command_line_options;
+namespace cs = packets::cs;
+
+using options = clopts< // clang-format off
+    option<"--turns", "Number of turns to measure (default: 5000)", i64>,
+    option<"--port", "Port to run the server on", i64>,
+    option<"--server", "Path to the server executable (default: ./PrescriptivismServer)">,
+    option<"--output", "Write the results to this file as JSON">,
+    help<>
+>; // clang-format on
+
+namespace {
+using Clock = chr::steady_clock;
+
+/// How long to wait for the server to respond before giving up.
+constexpr chr::seconds Timeout = 10s;
+
+struct Config {
+    usz turns;
+    u16 port;
+    std::string server;
+};
+
+/// One of the two players.
+struct BenchClient : headless::GameObserver {
+    std::unique_ptr<headless::Client> client;
+
+    /// When we last received these packets.
+    std::optional<Clock::time_point> end_turn;
+    std::optional<Clock::time_point> sound_added;
+
+    /// Why we were disconnected, if we were.
+    std::optional<headless::DisconnectReason> disconnect_reason;
+
+    void on_disconnect(headless::DisconnectReason reason) override { disconnect_reason = reason; }
+
+    void on_word_choice(const constants::Word& word) override {
+        client->game.choose_word(word);
+    }
+
+    void on_end_turn() override { end_turn = Clock::now(); }
+    void on_sound_added(PlayerId, u32, CardId) override { sound_added = Clock::now(); }
+
+    void on_card_choice(const packets::CardChoiceChallenge& c) override {
+        std::vector<u32> indices;
+        if (c.mode != packets::CardChoiceChallenge::Mode::AtMost)
+            for (u32 i = 0; i < c.count and i < c.cards.size(); i++)
+                indices.push_back(i);
+        client->game.answer_card_choice(std::move(indices));
+    }
+
+    void on_prompt_negation(CardId) override {
+        client->game.answer_negation(false);
+    }
+};
+
+/// An action we’re waiting on the server to process.
+struct Pending {
+    Clock::time_point sent;
+    usz actor;
+
+    /// Whether this is a sound card being played, i.e. whether we
+    /// want to measure this.
+    bool measure;
+};
+
+auto SpawnServer(const Config& cfg, u16 port) -> pid_t {
+    auto pid = fork();
+    if (pid == 0) {
+        auto port_str = std::to_string(port);
+        execl(
+            cfg.server.c_str(),
+            "PrescriptivismServer",
+            "--port",
+            port_str.c_str(),
+            "--pwd",
+            "password",
+            "--log-level",
+            "warning",
+            nullptr
+        );
+        std::println(stderr, "Failed to start server: {}", std::strerror(errno));
+        _Exit(1);
+    }
+    return pid;
+}
+
+/// Play a single game to completion, or until we have enough samples.
+auto RunGame(const Config& cfg, u16 port, std::vector<u32>& samples) -> Result<> {
+    auto server = SpawnServer(cfg, port);
+    defer {
+        kill(server, SIGTERM);
+        waitpid(server, nullptr, 0);
+    };
+
+    // Connect both players; the server may take a moment to start.
+    std::array<BenchClient, constants::PlayersPerGame> clients;
+    for (auto [i, c] : clients | vws::enumerate) {
+        auto deadline = Clock::now() + Timeout;
+        for (;;) {
+            auto res = headless::Client::Connect("localhost", port, std::format("bench{}", i), "password", &c);
+            if (res) {
+                c.client = std::move(res.value());
+                break;
+            }
+
+            if (Clock::now() > deadline) return Error("Failed to connect to server: {}", res.error());
+            std::this_thread::sleep_for(50ms);
+        }
+    }
+
+    std::optional<Pending> pending;
+    auto last_progress = Clock::now();
+    while (samples.size() < cfg.turns) {
+        // Busy-poll so we notice replies as soon as they arrive.
+        for (auto& c : clients) c.client->tick();
+
+        // The server exits once the game is over; any other disconnect
+        // means that something went wrong, e.g. that we were kicked for
+        // an invalid move or that the server crashed.
+        for (auto [i, c] : clients | vws::enumerate) {
+            if (not c.disconnect_reason) continue;
+            if (*c.disconnect_reason == headless::DisconnectReason::GameOver) return {};
+            return Error("Player {} was disconnected before the game was over (reason {})", i, +*c.disconnect_reason);
+        }
+
+        auto now = Clock::now();
+        if (now - last_progress > Timeout) return Error("Server stopped responding");
+
+        // Check if the action we’re waiting for has been processed. For sound
+        // cards, this is the case once both players know about it.
+        if (pending) {
+            auto& actor = clients[pending->actor];
+            auto& other = clients[(pending->actor + 1) % clients.size()];
+            if (not actor.end_turn) continue;
+            if (pending->measure) {
+                if (not other.sound_added) continue;
+                auto done = std::max(*actor.end_turn, *other.sound_added);
+                samples.push_back(u32(chr::duration_cast<chr::microseconds>(done - pending->sent).count()));
+            }
+
+            pending = std::nullopt;
+            last_progress = now;
+            continue;
+        }
+
+        // Find the player whose turn it is.
+        auto it = rgs::find_if(clients, [](auto& c) {
+            return c.client->game.our_turn and not c.client->game.challenge;
+        });
+
+        if (it == clients.end()) continue;
+        auto& game = it->client->game;
+
+        // Play a sound card if we can; pass otherwise.
+        auto moves = game.legal_moves();
+        auto hand = game.hand;
+        auto sound = rgs::find_if(moves, [&](auto& m) {
+            auto p = m.template get_if<cs::PlaySingleTarget>();
+            return p and hand[p->card_index].is_sound();
+        });
+
+        if (sound == moves.end() and hand.empty()) continue;
+        for (auto& c : clients) c.end_turn = c.sound_added = std::nullopt;
+        pending = Pending{Clock::now(), usz(it - clients.begin()), sound != moves.end()};
+        if (sound != moves.end()) game.play(*sound);
+        else game.play(cs::Pass{0});
+    }
+
+    return {};
+}
+
+auto Percentile(std::span<const u32> sorted, f64 p) -> u32 {
+    if (sorted.empty()) return 0;
+    return sorted[usz(p * f64(sorted.size() - 1))];
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    auto opts = options::parse(argc, argv);
+    SetLogLevel(LogLevel::Warning);
+    signal(SIGPIPE, SIG_IGN);
+
+    i64 turns = opts.get_or<"--turns">(5'000);
+    if (turns <= 0) {
+        std::println(stderr, "ERROR: --turns must be positive");
+        return 1;
+    }
+
+    i64 port = opts.get_or<"--port">(net::DefaultPort);
+    if (port <= 0 or port > std::numeric_limits<u16>::max()) {
+        std::println(stderr, "ERROR: invalid port {}", port);
+        return 1;
+    }
+
+    Config cfg{
+        .turns = usz(turns),
+        .port = u16(port),
+        .server = opts.get_or<"--server">("./PrescriptivismServer"),
+    };
+
+    // A single game isn’t long enough to collect thousands of samples,
+    // so keep starting new ones until we have enough.
+    std::vector<u32> samples;
+    samples.reserve(cfg.turns);
+    usz games = 0;
+    while (samples.size() < cfg.turns) {
+        auto before = samples.size();
+        if (auto res = RunGame(cfg, cfg.port, samples); not res) {
+            std::println(stderr, "ERROR: {}", res.error());
+            return 1;
+        }
+
+        games++;
+        if (samples.size() == before) {
+            std::println(stderr, "ERROR: Game ended without any sound cards being played");
+            return 1;
+        }
+    }
+
+    rgs::sort(samples);
+    auto mean = f64(std::accumulate(samples.begin(), samples.end(), u64(0))) / f64(samples.size());
+    auto p50 = Percentile(samples, .5);
+    auto p99 = Percentile(samples, .99);
+    auto p999 = Percentile(samples, .999);
+    std::println("Turns:   {} in {} games", samples.size(), games);
+    std::println("Latency: p50 {:.2f}ms, p99 {:.2f}ms, p999 {:.2f}ms, max {:.2f}ms, mean {:.2f}ms",
+        p50 / 1e3,
+        p99 / 1e3,
+        p999 / 1e3,
+        samples.back() / 1e3,
+        mean / 1e3
+    );
+
+    // Write a machine-readable summary so CI can compare runs.
+    if (auto path = opts.get<"--output">()) {
+        std::ofstream out{*path};
+        if (not out) {
+            std::println(stderr, "ERROR: Failed to open '{}' for writing", *path);
+            return 1;
+        }
+
+        std::println(
+            out,
+            R"({{"turns": {}, "games": {}, "p50_us": {}, "p99_us": {}, "p999_us": {}, "max_us": {}, "mean_us": {:.1f}}})",
+            samples.size(),
+            games,
+            p50,
+            p99,
+            p999,
+            samples.back(),
+            mean
+        );
+    }
+}
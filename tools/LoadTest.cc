@@ -0,0 +1,763 @@
+#include <Headless/Game.hh>
+
+#include <Shared/Constants.hh>
+#include <Shared/Packets.hh>
+#include <Shared/Utils.hh>
+
+#include <base/Base.hh>
+
+#include <clopts.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <print>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifndef __linux__
+#    error TODO: Non-linux support
+#endif
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace pr;
+using namespace command_line_options;
+namespace sc = packets::sc;
+namespace cs = packets::cs;
+
+using options = clopts< // clang-format off
+    option<"--bots", "Number of bots to run (default: 2)", i64>,
+    option<"--threads", "Number of threads to run the bots on (default: one per core)", i64>,
+    option<"--think", "Milliseconds a bot waits before making a move (default: 100)", i64>,
+    option<"--duration", "How many seconds to run for (default: 60)", i64>,
+    option<"--address", "The server address to connect to (default: localhost)">,
+    option<"--port", "The port of the first server; every room uses the next port", i64>,
+    option<"--pwd", "Password to the game (default: password)">,
+    option<"--log-level", "Minimum level of messages to log: trace, debug, info, warning, or error">,
+    flag<"--no-server", "Connect to servers that are already running instead of starting them">,
+    flag<"--soak", "Keep the servers running across games, churn connexions, and check for memory growth">,
+    option<"--admin-port", "Admin port of the first server; every room uses the next port", i64>,
+    option<"--churn", "Soak mode: average seconds between a bot disconnecting and reconnecting (default: 60)", i64>,
+    option<"--sample-interval", "Soak mode: seconds between server memory samples (default: 10)", i64>,
+    option<"--max-growth", "Soak mode: maximum heap growth per completed game, in bytes (default: 65536)", i64>,
+    help<>
+>; // clang-format on
+
+namespace {
+/// Set by the signal handler to stop the test early.
+std::atomic<bool> Stop = false;
+
+/// Number of actions whose results we’ve received across all threads.
+std::atomic<u64> TotalActions = 0;
+
+/// Statistics collected by a single worker thread.
+struct Results {
+    /// Time from sending an action to the server’s reply, in microseconds;
+    /// this includes the network and the time until the server’s next tick,
+    /// so see ActionHistogram for how long the server spent on the action.
+    std::vector<u32> latencies;
+    u64 games_started = 0;
+    u64 disconnects = 0;
+    u64 reconnects = 0;
+
+    /// Disconnects for any reason other than the game ending or us leaving.
+    u64 kicks = 0;
+
+    void merge(const Results& other) {
+        latencies.insert(latencies.end(), other.latencies.begin(), other.latencies.end());
+        games_started += other.games_started;
+        disconnects += other.disconnects;
+        reconnects += other.reconnects;
+        kicks += other.kicks;
+    }
+};
+
+struct Config {
+    usz bots;
+    usz threads;
+    chr::milliseconds think;
+    chr::seconds duration;
+    std::string address;
+    u16 port;
+    std::string password;
+    bool spawn_servers;
+    u16 admin_port;
+
+    /// Soak mode only.
+    bool soak;
+    chr::seconds churn;
+    chr::seconds sample_interval;
+    i64 max_growth;
+};
+
+// =============================================================================
+//  Bot
+// =============================================================================
+/// A headless client that plays random legal moves.
+///
+/// In soak mode, bots prefer power cards since those exercise the
+/// challenge code, drop their connexion every so often, and rejoin
+/// whenever they’re disconnected, e.g. because the game is over.
+class Bot : public headless::GameObserver {
+    LIBBASE_IMMOVABLE(Bot);
+
+    /// How long to wait before reconnecting.
+    static constexpr chr::milliseconds ReconnectDelay = 500ms;
+
+    std::unique_ptr<headless::Client> client;
+    const Config& cfg;
+    Results& results;
+    std::string name;
+    u16 port;
+    std::minstd_rand rng{std::random_device{}()};
+    bool disconnected = false;
+
+    /// When we sent the action we’re waiting on, if any.
+    std::optional<chr::steady_clock::time_point> action_sent;
+
+    /// When we’re going to make our next move.
+    chr::steady_clock::time_point next_action;
+
+    /// Soak mode: when we’re going to reconnect or drop our connexion.
+    chr::steady_clock::time_point reconnect_at;
+    chr::steady_clock::time_point churn_at;
+
+public:
+    Bot(const Config& cfg, Results& results, std::string name, u16 port)
+        : cfg(cfg), results(results), name(std::move(name)), port(port) {}
+
+    /// Connect to the server and log in; the server may still be starting
+    /// up, so this retries for a bit.
+    auto connect() -> Result<>;
+
+    /// Process incoming packets and make a move if it’s our turn.
+    void tick(chr::steady_clock::time_point now);
+
+    void on_disconnect(headless::DisconnectReason reason) override;
+    void on_word_choice(const constants::Word& word) override;
+    void on_start_game() override;
+    void on_start_turn() override;
+    void on_end_turn() override;
+    void on_card_choice(const packets::CardChoiceChallenge& c) override;
+    void on_prompt_negation(CardId) override;
+
+private:
+    void Act();
+    auto Connect() -> Result<>;
+    void RecordLatency();
+    void ScheduleChurn(chr::steady_clock::time_point now);
+};
+
+auto Bot::connect() -> Result<> {
+    auto deadline = chr::steady_clock::now() + 10s;
+    for (;;) {
+        auto res = Connect();
+        if (res) {
+            ScheduleChurn(chr::steady_clock::now());
+            return {};
+        }
+
+        if (chr::steady_clock::now() > deadline) return res;
+        std::this_thread::sleep_for(100ms);
+    }
+}
+
+auto Bot::Connect() -> Result<> {
+    client = Try(headless::Client::Connect(cfg.address, port, name, cfg.password, this));
+    action_sent = std::nullopt;
+    disconnected = false;
+    return {};
+}
+
+void Bot::ScheduleChurn(chr::steady_clock::time_point now) {
+    if (not cfg.soak) return;
+    auto secs = std::exponential_distribution<f64>{1 / f64(cfg.churn.count())}(rng);
+    churn_at = now + chr::duration_cast<chr::steady_clock::duration>(chr::duration<f64>(secs));
+}
+
+void Bot::tick(chr::steady_clock::time_point now) {
+    if (not client) return;
+    if (not disconnected) {
+        client->tick();
+        if (client->disconnected()) {
+            disconnected = true;
+            reconnect_at = now + ReconnectDelay;
+            results.disconnects++;
+        }
+    }
+
+    // Rejoin the server if we’re in soak mode. If the game is over, the
+    // server needs a tick to reset it, so don’t reconnect immediately.
+    if (disconnected) {
+        if (not cfg.soak or now < reconnect_at) return;
+        if (auto res = Connect(); not res) {
+            Log<LogLevel::Warning, LogCategory::Net>("{} failed to reconnect: {}", name, res.error());
+            reconnect_at = now + ReconnectDelay;
+            return;
+        }
+
+        results.reconnects++;
+        ScheduleChurn(now);
+        return;
+    }
+
+    // Drop our connexion every so often; we notice that we’re
+    // disconnected on the next tick.
+    if (cfg.soak and now >= churn_at) {
+        client->disconnect();
+        return;
+    }
+
+    if (client->game.our_turn and not action_sent and now >= next_action) Act();
+}
+
+void Bot::Act() {
+    auto& game = client->game;
+    if (game.challenge) return;
+    auto moves = game.legal_moves();
+
+    // Power cards cause challenges, which are what we most want to
+    // exercise in a soak test, so play them whenever we can.
+    if (cfg.soak) {
+        auto hand = game.hand;
+        std::vector<headless::Move> power;
+        rgs::copy_if(moves, std::back_inserter(power), [&](const headless::Move& m) {
+            return m.visit([&](const auto& p) { return hand[p.card_index].is_power(); });
+        });
+
+        if (not power.empty()) moves = std::move(power);
+    }
+
+    // If there is nothing we can play, discard a random card instead.
+    if (moves.empty()) {
+        if (game.hand.empty()) return;
+        moves.emplace_back(cs::Pass{u32(std::uniform_int_distribution<usz>{0, game.hand.size() - 1}(rng))});
+    }
+
+    game.play(moves[std::uniform_int_distribution<usz>{0, moves.size() - 1}(rng)]);
+    action_sent = chr::steady_clock::now();
+}
+
+void Bot::RecordLatency() {
+    if (not action_sent) return;
+    auto latency = chr::duration_cast<chr::microseconds>(chr::steady_clock::now() - *action_sent);
+    results.latencies.push_back(u32(latency.count()));
+    action_sent = std::nullopt;
+    TotalActions.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Bot::on_disconnect(headless::DisconnectReason reason) {
+    // The server uses ‘GameOver’ when the game is over, and we use
+    // ‘Unspecified’ when we leave voluntarily; anything else is worth
+    // flagging.
+    if (reason == headless::DisconnectReason::GameOver) return;
+    if (reason == headless::DisconnectReason::Unspecified) return;
+    Log<LogLevel::Warning, LogCategory::Net>("{} was disconnected by the server (reason {})", name, u32(reason));
+    results.kicks++;
+}
+
+void Bot::on_word_choice(const constants::Word& word) {
+    // The word we’re dealt is always valid, so just send it back.
+    client->game.choose_word(word);
+}
+
+void Bot::on_start_game() {
+    action_sent = std::nullopt;
+    results.games_started++;
+}
+
+void Bot::on_start_turn() {
+    next_action = chr::steady_clock::now() + cfg.think;
+}
+
+void Bot::on_end_turn() {
+    RecordLatency();
+}
+
+void Bot::on_card_choice(const packets::CardChoiceChallenge& c) {
+    // This is the server’s reply to a card that targets a player.
+    RecordLatency();
+
+    // Take as few cards as we’re allowed to.
+    std::vector<u32> indices;
+    if (c.mode != packets::CardChoiceChallenge::Mode::AtMost)
+        for (u32 i = 0; i < c.count and i < c.cards.size(); i++)
+            indices.push_back(i);
+
+    client->game.answer_card_choice(std::move(indices));
+}
+
+void Bot::on_prompt_negation(CardId) {
+    client->game.answer_negation(false);
+}
+
+// =============================================================================
+//  Soak Test
+// =============================================================================
+/// How long the server spent handling game actions.
+struct ActionHistogram {
+    /// Upper bound of each bucket, in seconds, and the cumulative
+    /// number of actions in that bucket.
+    std::vector<std::pair<f64, u64>> buckets;
+    u64 count = 0;
+    f64 sum = 0; ///< In seconds.
+
+    void merge(const ActionHistogram& other) {
+        if (buckets.empty()) buckets = other.buckets;
+        else for (auto [b, o] : vws::zip(buckets, other.buckets)) b.second += o.second;
+        count += other.count;
+        sum += other.sum;
+    }
+
+    /// Get the upper bound of the bucket that contains a percentile.
+    auto percentile(f64 p) const -> std::string {
+        auto rank = u64(std::ceil(p * f64(count)));
+        for (auto [bound, n] : buckets)
+            if (n >= rank) return std::format("≤{:.2f}", bound * 1e3);
+        return buckets.empty() ? "?" : std::format(">{:.2f}", buckets.back().first * 1e3);
+    }
+};
+
+/// The metrics we care about from a server’s admin endpoint.
+struct ServerSample {
+    u64 resident_memory = 0;
+    u64 heap = 0;
+    u64 connexions = 0;
+    u64 buffer_capacity = 0;
+    u64 games_completed = 0;
+    ActionHistogram actions;
+};
+
+/// A room that we’re monitoring.
+struct Room {
+    std::optional<pid_t> server;
+    u16 admin_port = 0;
+    std::vector<ServerSample> samples;
+    bool crashed = false;
+};
+
+/// Fetch the statistics from a server’s admin endpoint.
+auto Scrape(u16 admin_port) -> Result<ServerSample> {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return Error("socket(): {}", std::strerror(errno));
+    defer { ::close(fd); };
+
+    timeval timeout{.tv_sec = 2, .tv_usec = 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof timeout);
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(admin_port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) < 0)
+        return Error("connect(): {}", std::strerror(errno));
+
+    // The admin server closes the connexion after responding.
+    std::string_view request = "GET /metrics HTTP/1.0\r\n\r\n";
+    if (::send(fd, request.data(), request.size(), 0) < 0)
+        return Error("send(): {}", std::strerror(errno));
+
+    std::string response;
+    char buf[4096];
+    for (;;) {
+        auto n = ::recv(fd, buf, sizeof buf, 0);
+        if (n < 0) return Error("recv(): {}", std::strerror(errno));
+        if (n == 0) break;
+        response.append(buf, usz(n));
+    }
+
+    // Every metric is on its own line, followed by its value.
+    ServerSample sample;
+    for (auto line : response | vws::split('\n')) {
+        std::string_view l{line.begin(), line.end()};
+        if (l.empty() or l.starts_with('#')) continue;
+        auto space = l.rfind(' ');
+        if (space == std::string_view::npos) continue;
+
+        auto name = l.substr(0, space);
+        auto value = l.substr(space + 1);
+        auto Parse = [&](std::string_view metric, auto& out) {
+            if (name == metric) std::from_chars(value.data(), value.data() + value.size(), out);
+        };
+
+        // The +Inf bucket is the same as the count, so skip it.
+        static constexpr std::string_view ActionBucket = "prescriptivism_action_duration_seconds_bucket{le=\"";
+        if (name.starts_with(ActionBucket) and not name.contains("+Inf")) {
+            auto le = name.substr(ActionBucket.size());
+            auto& [bound, count] = sample.actions.buckets.emplace_back();
+            std::from_chars(le.data(), le.data() + le.size(), bound);
+            std::from_chars(value.data(), value.data() + value.size(), count);
+        }
+
+        Parse("prescriptivism_resident_memory_bytes", sample.resident_memory);
+        Parse("prescriptivism_heap_allocated_bytes", sample.heap);
+        Parse("prescriptivism_connexions", sample.connexions);
+        Parse("prescriptivism_buffer_capacity_bytes", sample.buffer_capacity);
+        Parse("prescriptivism_games_completed_total", sample.games_completed);
+        Parse("prescriptivism_action_duration_seconds_count", sample.actions.count);
+        Parse("prescriptivism_action_duration_seconds_sum", sample.actions.sum);
+    }
+
+    return sample;
+}
+
+/// Sample every room and check that none of the servers have died.
+void SampleRooms(std::span<Room> rooms) {
+    ServerSample total;
+    usz crashed = 0;
+    for (auto& r : rooms) {
+        if (r.server and not r.crashed and ::waitpid(*r.server, nullptr, WNOHANG) == *r.server) {
+            Log<LogLevel::Error, LogCategory::Net>("Server for admin port {} has exited", r.admin_port);
+            r.crashed = true;
+        }
+
+        if (r.crashed) {
+            crashed++;
+            continue;
+        }
+
+        auto s = Scrape(r.admin_port);
+        if (not s) {
+            Log<LogLevel::Warning, LogCategory::Net>("Failed to sample admin port {}: {}", r.admin_port, s.error());
+            continue;
+        }
+
+        r.samples.push_back(s.value());
+        total.resident_memory += s.value().resident_memory;
+        total.heap += s.value().heap;
+        total.connexions += s.value().connexions;
+        total.buffer_capacity += s.value().buffer_capacity;
+        total.games_completed += s.value().games_completed;
+    }
+
+    Log(
+        "{} actions, {} games completed, {} connexions, RSS {} KiB, heap {} KiB, buffers {} KiB{}",
+        TotalActions.load(std::memory_order_relaxed),
+        total.games_completed,
+        total.connexions,
+        total.resident_memory / 1024,
+        total.heap / 1024,
+        total.buffer_capacity / 1024,
+        crashed ? std::format(", {} servers crashed", crashed) : ""
+    );
+}
+
+/// Estimate how much a room’s heap grows per completed game.
+///
+/// Memory usage fluctuates a lot during a game, so we take the smallest
+/// heap size seen while each game was being played as that game’s baseline,
+/// and fit a line through the baselines. The first game is skipped since
+/// that’s where everything is warming up.
+auto HeapGrowthPerGame(const Room& r) -> std::optional<f64> {
+    std::vector<std::pair<f64, f64>> baselines;
+    for (auto& s : r.samples) {
+        if (s.games_completed == 0) continue;
+        auto game = f64(s.games_completed);
+        if (baselines.empty() or baselines.back().first != game) baselines.emplace_back(game, f64(s.heap));
+        else baselines.back().second = std::min(baselines.back().second, f64(s.heap));
+    }
+
+    // We need a few games for this to mean anything.
+    if (baselines.size() < 3) return std::nullopt;
+    f64 mx = 0, my = 0;
+    for (auto [x, y] : baselines) {
+        mx += x;
+        my += y;
+    }
+
+    mx /= f64(baselines.size());
+    my /= f64(baselines.size());
+
+    f64 num = 0, den = 0;
+    for (auto [x, y] : baselines) {
+        num += (x - mx) * (y - my);
+        den += (x - mx) * (x - mx);
+    }
+
+    return den == 0 ? 0 : num / den;
+}
+
+/// Check the soak test results; returns false if it failed.
+bool SoakReport(const Config& cfg, std::span<const Room> rooms) {
+    bool ok = true;
+    usz crashed = 0, measured = 0;
+    std::optional<std::pair<usz, f64>> worst;
+    for (auto [i, r] : rooms | vws::enumerate) {
+        if (r.crashed) crashed++;
+        auto growth = HeapGrowthPerGame(r);
+        if (not growth) continue;
+        measured++;
+        if (not worst or *growth > worst->second) worst = {usz(i), *growth};
+    }
+
+    std::println("Soak:          {} rooms measured, {} servers crashed", measured, crashed);
+    if (crashed) ok = false;
+    if (worst) {
+        auto& r = rooms[worst->first];
+        std::println(
+            "Heap growth:   {:.0f} bytes/game in the worst room (admin port {}, {} games, RSS {} KiB → {} KiB)",
+            worst->second,
+            r.admin_port,
+            r.samples.back().games_completed,
+            r.samples.front().resident_memory / 1024,
+            r.samples.back().resident_memory / 1024
+        );
+
+        if (worst->second > f64(cfg.max_growth)) {
+            std::println(stderr, "ERROR: Heap grows by more than {} bytes per game", cfg.max_growth);
+            ok = false;
+        }
+    } else {
+        std::println("Heap growth:   not enough games completed to measure; run for longer");
+    }
+
+    return ok;
+}
+
+// =============================================================================
+//  Driver
+// =============================================================================
+auto Percentile(std::span<const u32> sorted, f64 p) -> u32 {
+    if (sorted.empty()) return 0;
+    return sorted[usz(p * f64(sorted.size() - 1))];
+}
+
+auto SpawnServers(const Config& cfg, usz rooms) -> std::vector<pid_t> {
+    std::vector<pid_t> servers;
+    for (usz i = 0; i < rooms; i++) {
+        std::vector<std::string> args{
+            "PrescriptivismServer",
+            "--port",
+            std::to_string(cfg.port + i),
+            "--pwd",
+            cfg.password,
+            "--log-level",
+            "warning",
+        };
+
+        // We always need the admin endpoint for the server-side latency.
+        args.push_back("--admin-port");
+        args.push_back(std::to_string(cfg.admin_port + i));
+        if (cfg.soak) args.push_back("--keep-running");
+
+        auto pid = fork();
+        if (pid == 0) {
+            std::vector<char*> argv;
+            for (auto& a : args) argv.push_back(a.data());
+            argv.push_back(nullptr);
+            execv("./PrescriptivismServer", argv.data());
+            std::println(stderr, "Failed to start server: {}", std::strerror(errno));
+            _Exit(1);
+        }
+
+        servers.push_back(pid);
+    }
+    return servers;
+}
+
+void RunWorker(const Config& cfg, std::span<const usz> bot_ids, Results& results) {
+    std::vector<std::unique_ptr<Bot>> bots;
+    bots.reserve(bot_ids.size());
+    for (auto i : bot_ids) {
+        auto room = i / constants::PlayersPerGame;
+        auto& bot = bots.emplace_back(std::make_unique<Bot>(cfg, results, std::format("bot{}", i), u16(cfg.port + room)));
+        auto res = bot->connect();
+
+        if (not res) {
+            Log<LogLevel::Error, LogCategory::Net>("Bot {} failed to connect: {}", i, res.error());
+            results.disconnects++;
+        }
+    }
+
+    auto end = chr::steady_clock::now() + cfg.duration;
+    while (not Stop.load(std::memory_order_relaxed)) {
+        auto now = chr::steady_clock::now();
+        if (now >= end) break;
+        for (auto& b : bots) b->tick(now);
+        std::this_thread::sleep_for(1ms);
+    }
+}
+
+/// Collect the server-side action durations from every room.
+auto ScrapeActions(const Config& cfg, usz rooms) -> std::optional<ActionHistogram> {
+    std::optional<ActionHistogram> total;
+    for (usz i = 0; i < rooms; i++) {
+        auto port = u16(cfg.admin_port + i);
+        auto s = Scrape(port);
+        if (not s) {
+            Log<LogLevel::Warning, LogCategory::Net>("Failed to collect action durations from admin port {}: {}", port, s.error());
+            continue;
+        }
+
+        if (not total) total.emplace();
+        total->merge(s.value().actions);
+    }
+    return total;
+}
+
+void Report(
+    const Config& cfg,
+    Results& results,
+    const std::optional<ActionHistogram>& actions,
+    chr::steady_clock::duration elapsed
+) {
+    rgs::sort(results.latencies);
+    auto secs = chr::duration<f64>(elapsed).count();
+    std::println("Bots:          {} in {} rooms on {} threads", cfg.bots, cfg.bots / constants::PlayersPerGame, cfg.threads);
+    std::println("Duration:      {:.1f}s", secs);
+    std::println("Games started: {}", results.games_started / constants::PlayersPerGame);
+    std::println("Disconnects:   {} ({} kicked, {} reconnects)", results.disconnects, results.kicks, results.reconnects);
+    std::println("Actions:       {} ({:.1f}/s)", results.latencies.size(), f64(results.latencies.size()) / secs);
+    std::println("Client (ms):   p50 {:.2f}, p90 {:.2f}, p99 {:.2f}, p999 {:.2f}, max {:.2f}",
+        Percentile(results.latencies, .5) / 1e3,
+        Percentile(results.latencies, .9) / 1e3,
+        Percentile(results.latencies, .99) / 1e3,
+        Percentile(results.latencies, .999) / 1e3,
+        results.latencies.empty() ? 0.0 : results.latencies.back() / 1e3
+    );
+
+    // The server only reports histogram buckets, so these are upper bounds.
+    if (not actions or actions->count == 0) {
+        std::println("Server (ms):   unavailable; is the admin endpoint enabled?");
+        return;
+    }
+
+    std::println("Server (ms):   p50 {}, p90 {}, p99 {}, p999 {}, mean {:.3f}",
+        actions->percentile(.5),
+        actions->percentile(.9),
+        actions->percentile(.99),
+        actions->percentile(.999),
+        actions->sum / f64(actions->count) * 1e3
+    );
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    auto opts = options::parse(argc, argv);
+
+    if (auto level = opts.get<"--log-level">()) {
+        auto parsed = ParseLogLevel(*level);
+        if (not parsed) {
+            std::println(stderr, "ERROR: {}", parsed.error());
+            return 1;
+        }
+
+        SetLogLevel(parsed.value());
+    }
+
+    auto bots = opts.get_or<"--bots">(i64(constants::PlayersPerGame));
+    if (bots <= 0 or bots % i64(constants::PlayersPerGame) != 0) {
+        std::println(stderr, "ERROR: --bots must be a positive multiple of {}", constants::PlayersPerGame);
+        return 1;
+    }
+
+    i64 port = opts.get_or<"--port">(net::DefaultPort);
+    auto rooms = usz(bots) / constants::PlayersPerGame;
+    if (port <= 0 or port + i64(rooms) - 1 > std::numeric_limits<u16>::max()) {
+        std::println(stderr, "ERROR: invalid port {}", port);
+        return 1;
+    }
+
+    Config cfg{
+        .bots = usz(bots),
+        .threads = usz(std::max<i64>(1, opts.get_or<"--threads">(i64(std::thread::hardware_concurrency())))),
+        .think = chr::milliseconds(std::max<i64>(0, opts.get_or<"--think">(100))),
+        .duration = chr::seconds(std::max<i64>(1, opts.get_or<"--duration">(60))),
+        .address = opts.get_or<"--address">("localhost"),
+        .port = u16(port),
+        .password = opts.get_or<"--pwd">("password"),
+        .spawn_servers = not opts.get<"--no-server">(),
+        .admin_port = 0,
+        .soak = opts.get<"--soak">(),
+        .churn = chr::seconds(std::max<i64>(1, opts.get_or<"--churn">(60))),
+        .sample_interval = chr::seconds(std::max<i64>(1, opts.get_or<"--sample-interval">(10))),
+        .max_growth = opts.get_or<"--max-growth">(64 * 1024),
+    };
+
+    i64 admin_port = opts.get_or<"--admin-port">(port + 10'000);
+    if (admin_port <= 0 or admin_port + i64(rooms) - 1 > std::numeric_limits<u16>::max()) {
+        std::println(stderr, "ERROR: invalid admin port {}", admin_port);
+        return 1;
+    }
+
+    cfg.admin_port = u16(admin_port);
+
+    // Don’t use more threads than rooms; both bots in a room go on
+    // the same thread so a room’s latency isn’t affected by how busy
+    // other threads are.
+    cfg.threads = std::min(cfg.threads, rooms);
+
+    signal(SIGINT, [](int) { Stop.store(true); });
+    signal(SIGTERM, [](int) { Stop.store(true); });
+    signal(SIGPIPE, SIG_IGN);
+
+    std::vector<pid_t> servers;
+    if (cfg.spawn_servers) servers = SpawnServers(cfg, rooms);
+
+    std::vector<Room> soak_rooms;
+    if (cfg.soak) {
+        for (usz i = 0; i < rooms; i++) {
+            auto& r = soak_rooms.emplace_back();
+            r.admin_port = u16(cfg.admin_port + i);
+            if (cfg.spawn_servers) r.server = servers[i];
+        }
+    }
+
+    // Distribute the rooms across the threads.
+    std::vector<std::vector<usz>> assignments(cfg.threads);
+    for (usz i = 0; i < cfg.bots; i++)
+        assignments[(i / constants::PlayersPerGame) % cfg.threads].push_back(i);
+
+    std::vector<Results> results(cfg.threads);
+    auto start = chr::steady_clock::now();
+    {
+        std::vector<std::jthread> workers;
+        for (usz i = 0; i < cfg.threads; i++)
+            workers.emplace_back([&, i] { RunWorker(cfg, assignments[i], results[i]); });
+
+        // Print progress while we wait; in soak mode, also sample the servers.
+        u64 last_actions = 0;
+        auto end = start + cfg.duration;
+        auto interval = cfg.soak ? chr::steady_clock::duration(cfg.sample_interval) : 5s;
+        while (not Stop.load() and chr::steady_clock::now() < end) {
+            std::this_thread::sleep_for(std::min<chr::steady_clock::duration>(interval, end - chr::steady_clock::now()));
+            if (cfg.soak) {
+                SampleRooms(soak_rooms);
+                continue;
+            }
+
+            auto actions = TotalActions.load(std::memory_order_relaxed);
+            Log("{} actions ({} since last report)", actions, actions - last_actions);
+            last_actions = actions;
+        }
+    }
+
+    // Take one last sample before we shut everything down.
+    if (cfg.soak) SampleRooms(soak_rooms);
+    auto actions = ScrapeActions(cfg, rooms);
+
+    auto elapsed = chr::steady_clock::now() - start;
+    for (auto pid : servers) kill(pid, SIGTERM);
+    for (auto pid : servers) waitpid(pid, nullptr, 0);
+
+    Results total;
+    for (auto& r : results) total.merge(r);
+    Report(cfg, total, actions, elapsed);
+    if (cfg.soak and not SoakReport(cfg, soak_rooms)) return 1;
+}